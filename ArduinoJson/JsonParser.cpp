@@ -5,9 +5,14 @@
 
 // This file is here to help the Arduino IDE find the .cpp files
 
+#include "JsonParser/JsonArenaParser.cpp"
 #include "JsonParser/JsonArray.cpp"
 #include "JsonParser/JsonObject.cpp"
+#include "JsonParser/JsonObjectIndexBase.cpp"
 #include "JsonParser/JsonParserBase.cpp"
+#include "JsonParser/JsonSelectorBase.cpp"
+#include "JsonParser/JsonStreamParserBase.cpp"
 #include "JsonParser/JsonValue.cpp"
 #include "JsonParser/JsonToken.cpp"
+#include "JsonParser/JsonTokenArena.cpp"
 #include "JsonParser/jsmn.cpp"
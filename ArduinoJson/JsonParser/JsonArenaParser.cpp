@@ -0,0 +1,27 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#include "JsonArenaParser.h"
+
+using namespace ArduinoJson::Parser;
+
+JsonValue JsonArenaParser::parse(char* json)
+{
+    int count = JsonParserBase::countTokens(json);
+
+    tokenCount = (count > 0) ? count : 0;
+
+    if (tokenCount == 0)
+        return JsonToken::null();
+
+    jsmntok_t* tokens = arena->reserve(tokenCount);
+
+    if (tokens == 0)
+        return JsonToken::null();
+
+    // the same parser as JsonParser, given exactly the tokens it needs
+    JsonParserBase parser(tokens, tokenCount);
+    return parser.parse(json);
+}
@@ -0,0 +1,55 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#pragma once
+
+#include "JsonParserBase.h"
+#include "JsonTokenArena.h"
+
+namespace ArduinoJson
+{
+    namespace Parser
+    {
+        // A JSON parser that takes its tokens from a JsonTokenArena.
+        //
+        // Unlike JsonParser, the number of tokens isn't fixed at compile
+        // time: each document is read twice, once to count its tokens and
+        // once to parse it into exactly that many tokens of the arena.
+        //
+        // CAUTION: JsonArray, JsonObject and JsonValue contain pointers to the
+        // tokens of the arena, so they are only valid until the next parse()
+        // and as long as the arena is in memory.
+        class JsonArenaParser
+        {
+        public:
+
+            // Create a parser that takes its tokens from the specified arena
+            JsonArenaParser(JsonTokenArena* arena)
+                : arena(arena), tokenCount(0)
+            {
+            }
+
+            // Parse the JSON string and return a array
+            //
+            // Returns an invalid value if the string is not valid or if the
+            // arena can't hold its tokens.
+            //
+            // The content of the string may be altered to add '\0' at the
+            // end of string tokens
+            JsonValue parse(char* json);
+
+            // Get the number of tokens of the last document, even if the
+            // arena couldn't hold them, or 0 if it wasn't valid.
+            int getTokenCount()
+            {
+                return tokenCount;
+            }
+
+        private:
+            JsonTokenArena* arena;
+            int tokenCount;
+        };
+    }
+}
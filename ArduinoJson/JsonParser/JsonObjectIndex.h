@@ -0,0 +1,45 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#pragma once
+
+#include "JsonObjectIndexBase.h"
+
+namespace ArduinoJson
+{
+    namespace Parser
+    {
+        // An index of the keys of a JsonObject.
+        //
+        // Looking a key up in a JsonObject scans every key before it, and
+        // skips over their values. The index walks the object once, so that
+        // each lookup after that takes about constant time.
+        //
+        // You need to specify the number of slots, it should be larger than
+        // the number of keys of the object.
+        //
+        // CAUTION: like JsonObject, the index points to the tokens of the
+        // JsonParser, so it must not outlive the JsonParser.
+        template <int CAPACITY>
+        class JsonObjectIndex : public JsonObjectIndexBase
+        {
+        public:
+            JsonObjectIndex()
+                : JsonObjectIndexBase(entries, CAPACITY)
+            {
+            }
+
+            // Create the index of the specified object
+            JsonObjectIndex(JsonObject object)
+                : JsonObjectIndexBase(entries, CAPACITY)
+            {
+                build(object);
+            }
+
+        private:
+            JsonObjectIndexEntry entries[CAPACITY];
+        };
+    }
+}
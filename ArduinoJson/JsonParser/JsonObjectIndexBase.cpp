@@ -0,0 +1,91 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#include <string.h> // for strcmp()
+#include "JsonObjectIndexBase.h"
+
+using namespace ArduinoJson::Parser;
+
+bool JsonObjectIndexBase::build(JsonObject object)
+{
+    this->object = object;
+    count = 0;
+    isIndexed = false;
+
+    for (int i = 0; i < capacity; i++)
+    {
+        entries[i].key = 0;
+    }
+
+    if (!object.success())
+        return false;
+
+    for (JsonObjectIterator it = object.begin(); it != object.end(); ++it)
+    {
+        // keep a slot free, so that a missing key ends the probing
+        if (count == capacity - 1)
+        {
+            count = 0;
+            return false;
+        }
+
+        const char* key = it.key();
+        unsigned long keyHash = hash(key);
+
+        // linear probing
+        int slot = keyHash % capacity;
+        while (entries[slot].key != 0)
+        {
+            // like JsonObject, the first of duplicated keys wins
+            if (entries[slot].hash == keyHash && strcmp(entries[slot].key, key) == 0)
+                break;
+
+            slot = (slot + 1) % capacity;
+        }
+
+        if (entries[slot].key == 0)
+        {
+            entries[slot].key = key;
+            entries[slot].hash = keyHash;
+            entries[slot].value = it.value();
+            count++;
+        }
+    }
+
+    isIndexed = true;
+    return true;
+}
+
+JsonValue JsonObjectIndexBase::operator[](const char* key)
+{
+    if (key == 0)
+        return JsonValue();
+
+    if (!isIndexed)
+        return object[key];
+
+    unsigned long keyHash = hash(key);
+
+    for (int slot = keyHash % capacity; entries[slot].key != 0; slot = (slot + 1) % capacity)
+    {
+        if (entries[slot].hash == keyHash && strcmp(entries[slot].key, key) == 0)
+            return entries[slot].value;
+    }
+
+    return JsonValue();
+}
+
+// FNV-1a
+unsigned long JsonObjectIndexBase::hash(const char* key)
+{
+    unsigned long h = 2166136261UL;
+
+    while (*key)
+    {
+        h = (h ^ (unsigned char) *key++) * 16777619UL;
+    }
+
+    return h & 0xFFFFFFFFUL;
+}
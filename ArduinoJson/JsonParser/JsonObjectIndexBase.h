@@ -0,0 +1,74 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#pragma once
+
+#include "JsonObject.h"
+
+namespace ArduinoJson
+{
+    namespace Parser
+    {
+        // A key of an indexed JsonObject and its value
+        struct JsonObjectIndexEntry
+        {
+            // The key, or 0 if the slot is empty
+            const char* key;
+
+            // Hash of the key, compared before the key itself
+            unsigned long hash;
+
+            JsonValue value;
+        };
+
+        // Base class for the object index, in case you want to provide your own buffer
+        class JsonObjectIndexBase
+        {
+        public:
+
+            // Create an empty index using the provided slots
+            JsonObjectIndexBase(JsonObjectIndexEntry* entries, int capacity)
+                : entries(entries), capacity(capacity), count(0), isIndexed(false)
+            {
+            }
+
+            // Index the keys of the object, walking it only once.
+            //
+            // Returns false if the object has more keys than there are slots,
+            // lookups then fall back to scanning the object.
+            bool build(JsonObject object);
+
+            // Get the value associated with the specified key.
+            JsonValue operator[](const char* key);
+
+            // Tell if the specified key exists in the object.
+            bool containsKey(const char* key)
+            {
+                return operator[](key).success();
+            }
+
+            // Get the number of indexed keys
+            int size()
+            {
+                return count;
+            }
+
+            // Tell if the keys are indexed, rather than scanned for
+            bool success()
+            {
+                return isIndexed;
+            }
+
+        private:
+            JsonObjectIndexEntry* entries;
+            int capacity;
+            int count;
+            bool isIndexed;
+            JsonObject object;
+
+            static unsigned long hash(const char* key);
+        };
+    }
+}
@@ -25,3 +25,16 @@ JsonValue JsonParserBase::parse(char* json)
 
     return JsonToken(json, tokens);
 }
+
+int JsonParserBase::countTokens(const char* json)
+{
+    jsmn_parser parser;
+    jsmn_init(&parser);
+
+    jsmnerr_t status = jsmn_parse(&parser, json, NULL, 0);
+
+    if (JSMN_SUCCESS != status)
+        return status;
+
+    return parser.toknext;
+}
@@ -30,6 +30,13 @@ namespace ArduinoJson
             // end of string tokens
             JsonValue parse(char* json);
 
+            // Count the tokens needed to parse the JSON string, in a first
+            // pass that doesn't store them.
+            //
+            // Returns the number of tokens, or a negative jsmnerr_t if the
+            // string is not valid or not complete.
+            static int countTokens(const char* json);
+
             // Obsolete: use parse() instead
             DEPRECATED JsonArray parseArray(char* json)
             {
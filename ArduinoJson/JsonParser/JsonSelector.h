@@ -0,0 +1,41 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#pragma once
+
+#include "JsonSelectorBase.h"
+
+namespace ArduinoJson
+{
+    namespace Parser
+    {
+        // Extracts the values of a few paths, e.g. "moon_phase.sunset.hour",
+        // from a document in a single pass of a JsonStreamParser.
+        //
+        // The selector is the parser's handler: the objects that no path goes
+        // through are skipped, without keeping their keys or values, so only
+        // the selected values need to fit in memory. Arrays are skipped too,
+        // paths can only go through objects.
+        //
+        // You need to specify the number of paths, 32 at most, and the
+        // length of the longest value, without the terminator. Longer values
+        // are not found.
+        //
+        // CAUTION: the paths are not copied, they must outlive the selector.
+        template <int CAPACITY, int MAX_VALUE_LENGTH>
+        class JsonSelector : public JsonSelectorBase
+        {
+        public:
+            JsonSelector()
+                : JsonSelectorBase(paths, CAPACITY, values, MAX_VALUE_LENGTH + 1)
+            {
+            }
+
+        private:
+            JsonSelectorPath paths[CAPACITY];
+            char values[CAPACITY * (MAX_VALUE_LENGTH + 1)];
+        };
+    }
+}
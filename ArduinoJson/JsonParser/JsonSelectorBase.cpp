@@ -0,0 +1,150 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#include <stdlib.h> // for strtol()
+#include <string.h> // for strlen(), strncmp()
+#include "JsonSelectorBase.h"
+
+using namespace ArduinoJson::Parser;
+
+int JsonSelectorBase::add(const char* path)
+{
+    if (count == capacity || count == (int) sizeof(unsigned long) * 8 || path == 0)
+        return -1;
+
+    size_t length = strlen(path);
+
+    // the offsets are bytes
+    if (length == 0 || length > 254)
+        return -1;
+
+    JsonSelectorPath* p = &paths[count];
+    p->path = path;
+    p->segmentCount = 0;
+
+    size_t start = 0;
+
+    for (size_t i = 0; i <= length; i++)
+    {
+        if (path[i] != '.' && path[i] != 0)
+            continue;
+
+        if (i == start || p->segmentCount == JSON_SELECTOR_MAX_SEGMENTS)
+            return -1;
+
+        p->offsets[p->segmentCount++] = (unsigned char) start;
+        start = i + 1;
+    }
+
+    p->offsets[p->segmentCount] = (unsigned char) start;
+    p->found = false;
+    values[count * valueSize] = 0;
+
+    return count++;
+}
+
+void JsonSelectorBase::reset()
+{
+    for (int i = 0; i < count; i++)
+    {
+        paths[i].found = false;
+        values[i * valueSize] = 0;
+    }
+
+    level = 0;
+}
+
+bool JsonSelectorBase::found(int index)
+{
+    return index >= 0 && index < count && paths[index].found;
+}
+
+const char* JsonSelectorBase::asString(int index)
+{
+    return found(index) ? values + index * valueSize : 0;
+}
+
+long JsonSelectorBase::asLong(int index)
+{
+    return found(index) ? strtol(values + index * valueSize, 0, 10) : 0;
+}
+
+bool JsonSelectorBase::startContainer(jsmntype_t type, const char* key)
+{
+    unsigned long mask;
+
+    if (level == 0)
+    {
+        // the root, every path goes through it
+        mask = (count == (int) sizeof(unsigned long) * 8) ? ~0UL : (1UL << count) - 1;
+    }
+    else
+    {
+        // the keys of this level are the segments before the last
+        mask = match(matches[level], level - 1, key);
+
+        for (int i = 0; i < count; i++)
+        {
+            if (paths[i].segmentCount <= level)
+                mask &= ~(1UL << i);
+        }
+    }
+
+    if (type != JSMN_OBJECT)
+        mask = 0;
+
+    matches[++level] = mask;
+    return mask != 0;
+}
+
+void JsonSelectorBase::endContainer(jsmntype_t /*type*/)
+{
+    level--;
+}
+
+void JsonSelectorBase::value(jsmntype_t /*type*/, const char* key, const char* text)
+{
+    if (level == 0)
+        return;
+
+    unsigned long mask = match(matches[level], level - 1, key);
+
+    for (int i = 0; i < count; i++)
+    {
+        if (!(mask & (1UL << i)) || paths[i].segmentCount != level || paths[i].found)
+            continue;
+
+        // a value that doesn't fit is not found, rather than truncated
+        size_t length = strlen(text);
+        if (length >= (size_t) valueSize)
+            continue;
+
+        memcpy(values + i * valueSize, text, length + 1);
+        paths[i].found = true;
+    }
+}
+
+unsigned long JsonSelectorBase::match(unsigned long mask, int segment, const char* key)
+{
+    if (key == 0)
+        return 0;
+
+    size_t keyLength = strlen(key);
+
+    for (int i = 0; i < count; i++)
+    {
+        if (!(mask & (1UL << i)))
+            continue;
+
+        JsonSelectorPath* p = &paths[i];
+        size_t start = p->offsets[segment];
+        size_t length = p->offsets[segment + 1] - 1 - start;
+
+        if (length != keyLength || strncmp(p->path + start, key, length) != 0)
+            mask &= ~(1UL << i);
+    }
+
+    return mask;
+}
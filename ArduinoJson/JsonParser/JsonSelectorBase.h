@@ -0,0 +1,96 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#pragma once
+
+#include "JsonStreamParserBase.h"
+
+namespace ArduinoJson
+{
+    namespace Parser
+    {
+        // The most keys in a path, e.g. 3 for "moon_phase.sunset.hour"
+        const int JSON_SELECTOR_MAX_SEGMENTS = 8;
+
+        // A path compiled by JsonSelectorBase::add()
+        struct JsonSelectorPath
+        {
+            // The path itself, it's not copied
+            const char* path;
+
+            // Where each key starts in the path, the last offset is one past
+            // the end of the path.
+            unsigned char offsets[JSON_SELECTOR_MAX_SEGMENTS + 1];
+
+            unsigned char segmentCount;
+
+            // Set once the value has been extracted
+            bool found;
+        };
+
+        // Base class for the selector, in case you want to provide your own buffers
+        class JsonSelectorBase : public JsonStreamHandler
+        {
+        public:
+
+            // Create a selector without paths using the provided buffers.
+            //
+            // Each path gets valueSize chars to store its value, including
+            // the terminator.
+            JsonSelectorBase(JsonSelectorPath* paths, int capacity, char* values, int valueSize)
+                : paths(paths), capacity(capacity), values(values), valueSize(valueSize), count(0)
+            {
+                reset();
+            }
+
+            // Compile a path of keys separated by dots, e.g. "sunset.hour".
+            //
+            // Returns the index of the path, or -1 if there's no room left or
+            // if the path is empty, has an empty key or too many keys.
+            int add(const char* path);
+
+            // Forget the values found, before parsing a new document
+            void reset();
+
+            // Tell if a value has been found for the path
+            bool found(int index);
+
+            // Get the value of the path, strings are unescaped.
+            // Returns 0 if no value has been found.
+            const char* asString(int index);
+
+            // Convert the value of the path to a long integer, be it a number
+            // or a string. Returns 0 if no value has been found.
+            long asLong(int index);
+
+            // Get the number of paths
+            int size()
+            {
+                return count;
+            }
+
+            virtual bool startContainer(jsmntype_t type, const char* key);
+            virtual void endContainer(jsmntype_t type);
+            virtual void value(jsmntype_t type, const char* key, const char* text);
+
+        private:
+            JsonSelectorPath* paths;
+            int capacity;
+            char* values;
+            int valueSize;
+            int count;
+
+            // The number of objects and arrays the parser is in
+            int level;
+
+            // One bit per path that still matches the keys of each level,
+            // only the levels that aren't skipped are tracked.
+            unsigned long matches[JSON_SELECTOR_MAX_SEGMENTS + 2];
+
+            // Get the paths of the mask whose key at this index is the key
+            unsigned long match(unsigned long mask, int segment, const char* key);
+        };
+    }
+}
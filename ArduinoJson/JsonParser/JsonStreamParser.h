@@ -0,0 +1,38 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#pragma once
+
+#include "JsonStreamParserBase.h"
+
+namespace ArduinoJson
+{
+    namespace Parser
+    {
+        // A JSON parser that takes the document in chunks, as the bytes
+        // arrive, rather than as one string.
+        //
+        // It doesn't keep the document or its tokens, the values are sent to
+        // a JsonStreamHandler as they are parsed. So the memory it needs is
+        // bounded by the nesting depth and the longest key or value, not by
+        // the size of the document.
+        //
+        // You need to specify the maximum nesting depth and the length of the
+        // longest key or value, without the terminator.
+        template <int MAX_DEPTH, int MAX_TEXT_LENGTH>
+        class JsonStreamParser : public JsonStreamParserBase
+        {
+        public:
+            JsonStreamParser()
+                : JsonStreamParserBase(stack, MAX_DEPTH, scratch, sizeof(scratch))
+            {
+            }
+
+        private:
+            unsigned char stack[MAX_DEPTH];
+            char scratch[2 * (MAX_TEXT_LENGTH + 1)];
+        };
+    }
+}
@@ -0,0 +1,339 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#include <string.h> // for strlen(), memcpy()
+#include "JsonStreamParserBase.h"
+
+using namespace ArduinoJson::Parser;
+
+// What the grammar allows next
+enum
+{
+    EXPECT_VALUE,
+    EXPECT_VALUE_OR_END,    // after '['
+    EXPECT_KEY,             // after ',' in an object
+    EXPECT_KEY_OR_END,      // after '{'
+    EXPECT_COLON,
+    EXPECT_COMMA_OR_END,
+    EXPECT_NOTHING,         // after the top level value
+
+    // In a skipped container whose kind isn't known, after ','
+    EXPECT_KEY_OR_VALUE,
+    // ...and after the string that followed it
+    EXPECT_COLON_OR_COMMA_OR_END
+};
+
+// The kind of a skipped container that isn't known, no container is a
+// primitive
+#define KIND_UNKNOWN JSMN_PRIMITIVE
+
+// Where the lexer is
+enum
+{
+    LEXER_BETWEEN_TOKENS,
+    LEXER_IN_STRING,
+    LEXER_IN_ESCAPE,
+    LEXER_IN_PRIMITIVE
+};
+
+void JsonStreamParserBase::begin(JsonStreamHandler* handler)
+{
+    this->handler = handler;
+    level = 0;
+    result = JSMN_ERROR_PART;
+    skippedDepth = 0;
+    skippedKind = KIND_UNKNOWN;
+    expected = EXPECT_VALUE;
+    lexer = LEXER_BETWEEN_TOKENS;
+    isKey = false;
+    hasKey = false;
+    keyLength = 0;
+    textLength = 0;
+}
+
+jsmnerr_t JsonStreamParserBase::parse(const char* chunk)
+{
+    return parse(chunk, strlen(chunk));
+}
+
+jsmnerr_t JsonStreamParserBase::parse(const char* chunk, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        if (result == JSMN_ERROR_INVAL || result == JSMN_ERROR_NOMEM)
+            break;
+
+        jsmnerr_t r = parseChar(chunk[i]);
+
+        if (r != JSMN_SUCCESS)
+            result = r;
+    }
+
+    return result;
+}
+
+jsmnerr_t JsonStreamParserBase::finish()
+{
+    // a number at the top level has nothing after it to end it
+    if (lexer == LEXER_IN_PRIMITIVE && level == 0 && result == JSMN_ERROR_PART)
+    {
+        lexer = LEXER_BETWEEN_TOKENS;
+        endValue(JSMN_PRIMITIVE);
+    }
+
+    return result;
+}
+
+// Returns JSMN_SUCCESS if the character is allowed, or the error
+jsmnerr_t JsonStreamParserBase::parseChar(char c)
+{
+    switch (lexer)
+    {
+    case LEXER_IN_ESCAPE:
+        lexer = LEXER_IN_STRING;
+
+        switch (c)
+        {
+        case 'b': c = '\b'; break;
+        case 'f': c = '\f'; break;
+        case 'n': c = '\n'; break;
+        case 'r': c = '\r'; break;
+        case 't': c = '\t'; break;
+        case '\"': case '/': case '\\': case 'u': break;
+        default: return JSMN_ERROR_INVAL;
+        }
+
+        return appendText(c);
+
+    case LEXER_IN_STRING:
+        if (c == '\\')
+        {
+            lexer = LEXER_IN_ESCAPE;
+            return JSMN_SUCCESS;
+        }
+
+        if (c != '\"')
+            return appendText(c);
+
+        lexer = LEXER_BETWEEN_TOKENS;
+
+        if (isKey)
+        {
+            // keep the key until its value is complete
+            memcpy(key(), text(), textLength + 1);
+            keyLength = textLength;
+            hasKey = true;
+            expected = EXPECT_COLON;
+        }
+        else if (expected == EXPECT_KEY_OR_VALUE)
+        {
+            // what follows tells a key from a value
+            expected = EXPECT_COLON_OR_COMMA_OR_END;
+        }
+        else
+        {
+            endValue(JSMN_STRING);
+        }
+
+        return JSMN_SUCCESS;
+
+    case LEXER_IN_PRIMITIVE:
+        switch (c)
+        {
+        case '\t': case '\r': case '\n': case ' ':
+        case ',': case ']': case '}':
+            lexer = LEXER_BETWEEN_TOKENS;
+            endValue(JSMN_PRIMITIVE);
+
+            // the delimiter is a token of its own
+            break;
+
+        default:
+            if (c < 32 || c >= 127)
+                return JSMN_ERROR_INVAL;
+
+            return appendText(c);
+        }
+        break;
+    }
+
+    switch (c)
+    {
+    case '\t': case '\r': case '\n': case ' ':
+        return JSMN_SUCCESS;
+
+    case '{': case '[':
+        if (expected != EXPECT_VALUE && expected != EXPECT_VALUE_OR_END &&
+            expected != EXPECT_KEY_OR_VALUE)
+            return JSMN_ERROR_INVAL;
+
+        // the containers in a skipped one are only counted
+        if (skippedDepth)
+        {
+            skippedDepth++;
+            skippedKind = (c == '{') ? JSMN_OBJECT : JSMN_ARRAY;
+        }
+        else
+        {
+            if (level == maxDepth)
+                return JSMN_ERROR_NOMEM;
+
+            stack[level++] = (c == '{') ? JSMN_OBJECT : JSMN_ARRAY;
+
+            if (handler &&
+                !handler->startContainer((jsmntype_t) stack[level - 1], hasKey ? key() : 0))
+                skippedDepth = 1;
+        }
+
+        hasKey = false;
+        expected = (c == '{') ? EXPECT_KEY_OR_END : EXPECT_VALUE_OR_END;
+        return JSMN_SUCCESS;
+
+    case '}': case ']':
+        if (skippedDepth > 1)
+            return endSkippedContainer(c);
+
+        if (level == 0 || stack[level - 1] != ((c == '}') ? JSMN_OBJECT : JSMN_ARRAY))
+            return JSMN_ERROR_INVAL;
+
+        // an empty container, or a complete value before the end
+        if (expected != EXPECT_COMMA_OR_END &&
+            expected != ((c == '}') ? EXPECT_KEY_OR_END : EXPECT_VALUE_OR_END))
+            return JSMN_ERROR_INVAL;
+
+        level--;
+
+        // the skipped container itself ends
+        skippedDepth = 0;
+
+        if (handler)
+            handler->endContainer((jsmntype_t) stack[level]);
+
+        valueEnded();
+        return JSMN_SUCCESS;
+
+    case '\"':
+        if (expected == EXPECT_KEY || expected == EXPECT_KEY_OR_END)
+            isKey = true;
+        else if (expected == EXPECT_VALUE || expected == EXPECT_VALUE_OR_END ||
+            expected == EXPECT_KEY_OR_VALUE)
+            isKey = false;
+        else
+            return JSMN_ERROR_INVAL;
+
+        lexer = LEXER_IN_STRING;
+        textLength = 0;
+        text()[0] = 0;
+        return JSMN_SUCCESS;
+
+    case ':':
+        if (expected == EXPECT_COLON_OR_COMMA_OR_END)
+            skippedKind = JSMN_OBJECT;
+        else if (expected != EXPECT_COLON)
+            return JSMN_ERROR_INVAL;
+
+        expected = EXPECT_VALUE;
+        return JSMN_SUCCESS;
+
+    case ',':
+        if (expected == EXPECT_COLON_OR_COMMA_OR_END)
+            skippedKind = JSMN_ARRAY;
+        else if (expected != EXPECT_COMMA_OR_END)
+            return JSMN_ERROR_INVAL;
+
+        switch (skippedDepth > 1 ? skippedKind : stack[level - 1])
+        {
+        case JSMN_OBJECT: expected = EXPECT_KEY; break;
+        case JSMN_ARRAY: expected = EXPECT_VALUE; break;
+        default: expected = EXPECT_KEY_OR_VALUE; break;
+        }
+
+        return JSMN_SUCCESS;
+
+    default:
+        if (expected == EXPECT_KEY_OR_VALUE)
+            skippedKind = JSMN_ARRAY;
+        else if (expected != EXPECT_VALUE && expected != EXPECT_VALUE_OR_END)
+            return JSMN_ERROR_INVAL;
+
+        if (c < 32 || c >= 127)
+            return JSMN_ERROR_INVAL;
+
+        lexer = LEXER_IN_PRIMITIVE;
+        textLength = 0;
+        return appendText(c);
+    }
+}
+
+// The end of a container in a skipped one, there's no stack to check it
+// against, only the kind of the last container that started if it's still
+// known
+jsmnerr_t JsonStreamParserBase::endSkippedContainer(char c)
+{
+    unsigned char kind = (c == '}') ? JSMN_OBJECT : JSMN_ARRAY;
+
+    if (skippedKind != KIND_UNKNOWN && skippedKind != kind)
+        return JSMN_ERROR_INVAL;
+
+    // an empty container, or a complete value before the end, which can
+    // only be a string if it's in an array
+    if (expected != EXPECT_COMMA_OR_END &&
+        expected != ((c == '}') ? EXPECT_KEY_OR_END : EXPECT_VALUE_OR_END) &&
+        !(expected == EXPECT_COLON_OR_COMMA_OR_END && c == ']'))
+        return JSMN_ERROR_INVAL;
+
+    // the kinds of the containers it's in weren't kept
+    skippedDepth--;
+    skippedKind = KIND_UNKNOWN;
+
+    valueEnded();
+    return JSMN_SUCCESS;
+}
+
+jsmnerr_t JsonStreamParserBase::appendText(char c)
+{
+    // skipped text doesn't need to fit
+    if (skippedDepth)
+        return JSMN_SUCCESS;
+
+    // the other half of the scratch holds the key
+    if (textLength == scratchSize / 2 - 1)
+        return JSMN_ERROR_NOMEM;
+
+    text()[textLength++] = c;
+    text()[textLength] = 0;
+    return JSMN_SUCCESS;
+}
+
+void JsonStreamParserBase::endValue(jsmntype_t type)
+{
+    if (handler && !skippedDepth)
+        handler->value(type, hasKey ? key() : 0, text());
+
+    hasKey = false;
+    valueEnded();
+}
+
+void JsonStreamParserBase::valueEnded()
+{
+    if (level > 0)
+    {
+        expected = EXPECT_COMMA_OR_END;
+        return;
+    }
+
+    expected = EXPECT_NOTHING;
+    result = JSMN_SUCCESS;
+}
+
+char* JsonStreamParserBase::key()
+{
+    return scratch;
+}
+
+char* JsonStreamParserBase::text()
+{
+    return scratch + scratchSize / 2;
+}
@@ -0,0 +1,145 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#pragma once
+
+#include <stddef.h> // for size_t
+#include "jsmn.h"
+
+namespace ArduinoJson
+{
+    namespace Parser
+    {
+        // Receives the values of a document as JsonStreamParser parses it.
+        //
+        // The key is the value's key in its parent object, or 0 if the parent
+        // is an array or there's no parent. The key and the text only live
+        // until the method returns.
+        class JsonStreamHandler
+        {
+        public:
+            virtual ~JsonStreamHandler()
+            {
+            }
+
+            // An object or an array starts.
+            //
+            // Return false to skip its contents, they are still checked but
+            // not buffered or sent to the handler, until it ends. The
+            // containers in a skipped one are only counted, so they don't
+            // count towards the maximum depth, and a bracket that doesn't
+            // match the container it ends can go unnoticed in them.
+            virtual bool startContainer(jsmntype_t /*type*/, const char* /*key*/)
+            {
+                return true;
+            }
+
+            // The last object or array that started ends, skipped or not
+            virtual void endContainer(jsmntype_t /*type*/)
+            {
+            }
+
+            // A string or a primitive, strings are unescaped
+            virtual void value(jsmntype_t /*type*/, const char* /*key*/, const char* /*text*/)
+            {
+            }
+        };
+
+        // Base class for the streaming parser, in case you want to provide your own buffers
+        class JsonStreamParserBase
+        {
+        public:
+
+            // Create a parser using the provided buffers.
+            //
+            // The stack holds one byte per level of nesting outside skipped
+            // containers, the scratch holds the longest key and the longest
+            // value, including their terminators, so it is split in two
+            // halves.
+            JsonStreamParserBase(unsigned char* stack, int maxDepth, char* scratch, int scratchSize)
+                : stack(stack), maxDepth(maxDepth), scratch(scratch), scratchSize(scratchSize), handler(0)
+            {
+                begin(0);
+            }
+
+            // Start parsing a new document, the values are sent to the handler
+            void begin(JsonStreamHandler* handler);
+
+            // Parse the next chunk of the document.
+            //
+            // Returns JSMN_ERROR_PART while more bytes are expected,
+            // JSMN_SUCCESS once the document is complete, JSMN_ERROR_INVAL if
+            // it isn't valid JSON and JSMN_ERROR_NOMEM if it's nested deeper
+            // than the stack or has a key or a value longer than the scratch.
+            // Once an error is returned, it's returned until begin() is called.
+            jsmnerr_t parse(const char* chunk, size_t length);
+
+            // Parse the next NUL-terminated chunk of the document
+            jsmnerr_t parse(const char* chunk);
+
+            // Tell the parser the document has ended, so that a number at the
+            // top level is complete.
+            jsmnerr_t finish();
+
+            // Get the status of the parsing so far
+            jsmnerr_t status()
+            {
+                return result;
+            }
+
+            // Get the number of objects and arrays the parser is in, not
+            // counting the ones in a skipped container
+            int depth()
+            {
+                return level;
+            }
+
+        private:
+            unsigned char* stack;
+            int maxDepth;
+            char* scratch;
+            int scratchSize;
+            JsonStreamHandler* handler;
+
+            int level;
+            jsmnerr_t result;
+
+            // The number of containers open in the skipped one, counting
+            // itself, or 0
+            int skippedDepth;
+
+            // The kind of the last container that started in the skipped
+            // one, until a container ends in it and the kind of the one
+            // around it isn't known
+            unsigned char skippedKind;
+
+            // What the grammar allows next
+            unsigned char expected;
+
+            // Where the lexer is, within a string, a primitive...
+            unsigned char lexer;
+
+            // Set while the string being read is a key
+            bool isKey;
+
+            // Set while a key waits for its value
+            bool hasKey;
+
+            int keyLength;
+            int textLength;
+
+            jsmnerr_t parseChar(char c);
+            jsmnerr_t endSkippedContainer(char c);
+            jsmnerr_t appendText(char c);
+            void endValue(jsmntype_t type);
+
+            // Called once a value is complete, be it a container or not
+            void valueEnded();
+
+            char* key();
+            char* text();
+        };
+    }
+}
@@ -0,0 +1,39 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#include <stdlib.h> // for realloc(), free()
+#include "JsonTokenArena.h"
+
+using namespace ArduinoJson::Parser;
+
+JsonHeapTokenArena::~JsonHeapTokenArena()
+{
+    free(tokens);
+}
+
+bool JsonHeapTokenArena::grow(int count)
+{
+    if (count > maxCapacity)
+        return false;
+
+    // at least double, so that a few larger documents don't each realloc
+    int newCapacity = capacity * 2;
+
+    if (newCapacity < count)
+        newCapacity = count;
+
+    if (newCapacity > maxCapacity)
+        newCapacity = maxCapacity;
+
+    jsmntok_t* newTokens = (jsmntok_t*) realloc(tokens, newCapacity * sizeof(jsmntok_t));
+
+    // the old buffer is kept if there's not enough memory
+    if (newTokens == 0)
+        return false;
+
+    tokens = newTokens;
+    capacity = newCapacity;
+    return true;
+}
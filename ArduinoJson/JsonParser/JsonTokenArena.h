@@ -0,0 +1,84 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#pragma once
+
+#include "jsmn.h"
+
+namespace ArduinoJson
+{
+    namespace Parser
+    {
+        // The tokens of a JsonArenaParser, taken from a buffer provided by the
+        // caller.
+        //
+        // This arena doesn't grow, override grow() to provide a larger buffer
+        // when a document needs more tokens, JsonHeapTokenArena does so on
+        // the heap.
+        class JsonTokenArena
+        {
+        public:
+
+            // Create an arena using the provided buffer, which may be 0
+            JsonTokenArena(jsmntok_t* tokens, int capacity)
+                : tokens(tokens), capacity(capacity)
+            {
+            }
+
+            virtual ~JsonTokenArena()
+            {
+            }
+
+            // Get room for the specified number of tokens, growing the arena
+            // if needed. Returns 0 if it can't grow that much.
+            //
+            // CAUTION: growing the arena invalidates the tokens reserved before.
+            jsmntok_t* reserve(int count)
+            {
+                if (count > capacity && !grow(count))
+                    return 0;
+
+                return tokens;
+            }
+
+            // Get the number of tokens the arena holds
+            int size()
+            {
+                return capacity;
+            }
+
+        protected:
+            jsmntok_t* tokens;
+            int capacity;
+
+            // Replace the buffer with one of at least the specified number of
+            // tokens. Returns false if it can't.
+            virtual bool grow(int /*count*/)
+            {
+                return false;
+            }
+        };
+
+        // An arena that grows on the heap, up to a limit
+        class JsonHeapTokenArena : public JsonTokenArena
+        {
+        public:
+
+            // Create an empty arena that grows up to the specified number of tokens
+            JsonHeapTokenArena(int maxCapacity)
+                : JsonTokenArena(0, 0), maxCapacity(maxCapacity)
+            {
+            }
+
+            virtual ~JsonHeapTokenArena();
+
+        protected:
+            virtual bool grow(int count);
+
+        private:
+            int maxCapacity;
+        };
+    }
+}
@@ -2,6 +2,13 @@
 
 #include "jsmn.h"
 
+#ifdef JSMN_COMPACT_TOKENS
+/* Positions must fit in a token, and an end one past them must not be JSMN_UNSET */
+#define JSMN_TOO_LONG(pos) ((pos) >= JSMN_UNSET - 1)
+#else
+#define JSMN_TOO_LONG(pos) 0
+#endif
+
 /**
  * Allocates a fresh unused token from the token pull.
  */
@@ -12,7 +19,7 @@ static jsmntok_t *jsmn_alloc_token(jsmn_parser *parser,
 		return NULL;
 	}
 	tok = &tokens[parser->toknext++];
-	tok->start = tok->end = -1;
+	tok->start = tok->end = JSMN_UNSET;
 	tok->size = 0;
 #ifdef JSMN_PARENT_LINKS
 	tok->parent = -1;
@@ -42,6 +49,10 @@ static jsmnerr_t jsmn_parse_primitive(jsmn_parser *parser, const char *js,
 	start = parser->pos;
 
 	for (; js[parser->pos] != '\0'; parser->pos++) {
+		if (JSMN_TOO_LONG(parser->pos)) {
+			parser->pos = start;
+			return JSMN_ERROR_NOMEM;
+		}
 		switch (js[parser->pos]) {
 #ifndef JSMN_STRICT
 			/* In strict mode primitive must be followed by "," or "}" or "]" */
@@ -63,6 +74,11 @@ static jsmnerr_t jsmn_parse_primitive(jsmn_parser *parser, const char *js,
 #endif
 
 found:
+	if (tokens == NULL) {
+		parser->toknext++;
+		parser->pos--;
+		return JSMN_SUCCESS;
+	}
 	token = jsmn_alloc_token(parser, tokens, num_tokens);
 	if (token == NULL) {
 		parser->pos = start;
@@ -91,8 +107,17 @@ static jsmnerr_t jsmn_parse_string(jsmn_parser *parser, const char *js,
 	for (; js[parser->pos] != '\0'; parser->pos++) {
 		char c = js[parser->pos];
 
+		if (JSMN_TOO_LONG(parser->pos)) {
+			parser->pos = start;
+			return JSMN_ERROR_NOMEM;
+		}
+
 		/* Quote: end of string */
 		if (c == '\"') {
+			if (tokens == NULL) {
+				parser->toknext++;
+				return JSMN_SUCCESS;
+			}
 			token = jsmn_alloc_token(parser, tokens, num_tokens);
 			if (token == NULL) {
 				parser->pos = start;
@@ -130,6 +155,9 @@ static jsmnerr_t jsmn_parse_string(jsmn_parser *parser, const char *js,
 
 /**
  * Parse JSON string and fill tokens.
+ *
+ * If tokens is NULL, the tokens are only counted, in parser->toknext, and
+ * parser->toksuper counts the objects and arrays left open instead.
  */
 jsmnerr_t jsmn_parse(jsmn_parser *parser, const char *js, jsmntok_t *tokens, 
 		unsigned int num_tokens) {
@@ -141,9 +169,17 @@ jsmnerr_t jsmn_parse(jsmn_parser *parser, const char *js, jsmntok_t *tokens,
 		char c;
 		jsmntype_t type;
 
+		if (JSMN_TOO_LONG(parser->pos))
+			return JSMN_ERROR_NOMEM;
+
 		c = js[parser->pos];
 		switch (c) {
 			case '{': case '[':
+				if (tokens == NULL) {
+					parser->toknext++;
+					parser->toksuper++;
+					break;
+				}
 				token = jsmn_alloc_token(parser, tokens, num_tokens);
 				if (token == NULL)
 					return JSMN_ERROR_NOMEM;
@@ -159,13 +195,20 @@ jsmnerr_t jsmn_parse(jsmn_parser *parser, const char *js, jsmntok_t *tokens,
 				break;
 			case '}': case ']':
 				type = (c == '}' ? JSMN_OBJECT : JSMN_ARRAY);
+				if (tokens == NULL) {
+					/* Only unmatched closing brackets can be told apart */
+					if (parser->toksuper == -1)
+						return JSMN_ERROR_INVAL;
+					parser->toksuper--;
+					break;
+				}
 #ifdef JSMN_PARENT_LINKS
 				if (parser->toknext < 1) {
 					return JSMN_ERROR_INVAL;
 				}
 				token = &tokens[parser->toknext - 1];
 				for (;;) {
-					if (token->start != -1 && token->end == -1) {
+					if (token->start != JSMN_UNSET && token->end == JSMN_UNSET) {
 						if (token->type != type) {
 							return JSMN_ERROR_INVAL;
 						}
@@ -181,7 +224,7 @@ jsmnerr_t jsmn_parse(jsmn_parser *parser, const char *js, jsmntok_t *tokens,
 #else
 				for (i = parser->toknext - 1; i >= 0; i--) {
 					token = &tokens[i];
-					if (token->start != -1 && token->end == -1) {
+					if (token->start != JSMN_UNSET && token->end == JSMN_UNSET) {
 						if (token->type != type) {
 							return JSMN_ERROR_INVAL;
 						}
@@ -194,7 +237,7 @@ jsmnerr_t jsmn_parse(jsmn_parser *parser, const char *js, jsmntok_t *tokens,
 				if (i == -1) return JSMN_ERROR_INVAL;
 				for (; i >= 0; i--) {
 					token = &tokens[i];
-					if (token->start != -1 && token->end == -1) {
+					if (token->start != JSMN_UNSET && token->end == JSMN_UNSET) {
 						parser->toksuper = i;
 						break;
 					}
@@ -204,7 +247,7 @@ jsmnerr_t jsmn_parse(jsmn_parser *parser, const char *js, jsmntok_t *tokens,
 			case '\"':
 				r = jsmn_parse_string(parser, js, tokens, num_tokens);
 				if (r < 0) return r;
-				if (parser->toksuper != -1)
+				if (parser->toksuper != -1 && tokens != NULL)
 					tokens[parser->toksuper].size++;
 				break;
 			case '\t' : case '\r' : case '\n' : case ':' : case ',': case ' ': 
@@ -220,7 +263,7 @@ jsmnerr_t jsmn_parse(jsmn_parser *parser, const char *js, jsmntok_t *tokens,
 #endif
 				r = jsmn_parse_primitive(parser, js, tokens, num_tokens);
 				if (r < 0) return r;
-				if (parser->toksuper != -1)
+				if (parser->toksuper != -1 && tokens != NULL)
 					tokens[parser->toksuper].size++;
 				break;
 
@@ -233,9 +276,13 @@ jsmnerr_t jsmn_parse(jsmn_parser *parser, const char *js, jsmntok_t *tokens,
 		}
 	}
 
+	if (tokens == NULL) {
+		return parser->toksuper == -1 ? JSMN_SUCCESS : JSMN_ERROR_PART;
+	}
+
 	for (i = parser->toknext - 1; i >= 0; i--) {
 		/* Unmatched opened object or array */
-		if (tokens[i].start != -1 && tokens[i].end == -1) {
+		if (tokens[i].start != JSMN_UNSET && tokens[i].end == JSMN_UNSET) {
 			return JSMN_ERROR_PART;
 		}
 	}
@@ -16,7 +16,8 @@ typedef enum {
 } jsmntype_t;
 
 typedef enum {
-	/* Not enough tokens were provided */
+	/* Not enough tokens were provided, or the string is too long for
+	 * JSMN_COMPACT_TOKENS */
 	JSMN_ERROR_NOMEM = -1,
 	/* Invalid character inside JSON string */
 	JSMN_ERROR_INVAL = -2,
@@ -26,17 +27,34 @@ typedef enum {
 	JSMN_SUCCESS = 0
 } jsmnerr_t;
 
+/**
+ * Positions and sizes in a token. With JSMN_COMPACT_TOKENS they are 16-bit,
+ * so a token takes 8 bytes instead of 16 on a 32-bit processor, but the
+ * documents must be shorter than 64 KB.
+ */
+#ifdef JSMN_COMPACT_TOKENS
+typedef unsigned short jsmnpos_t;
+#define JSMN_UNSET ((jsmnpos_t) 0xFFFF)
+#else
+typedef int jsmnpos_t;
+#define JSMN_UNSET (-1)
+#endif
+
 /**
  * JSON token description.
  * @param		type	type (object, array, string etc.)
- * @param		start	start position in JSON data string
- * @param		end		end position in JSON data string
+ * @param		start	start position in JSON data string, or JSMN_UNSET
+ * @param		end		end position in JSON data string, or JSMN_UNSET
  */
 typedef struct {
+#ifdef JSMN_COMPACT_TOKENS
+	unsigned char type;
+#else
 	jsmntype_t type;
-	int start;
-	int end;
-	int size;
+#endif
+	jsmnpos_t start;
+	jsmnpos_t end;
+	jsmnpos_t size;
 #ifdef JSMN_PARENT_LINKS
 	int parent;
 #endif
@@ -60,6 +78,9 @@ void jsmn_init(jsmn_parser *parser);
 /**
  * Run JSON parser. It parses a JSON data string into and array of tokens, each describing
  * a single JSON object.
+ *
+ * If tokens is NULL, nothing is stored and parser->toknext is the number of tokens
+ * needed once it returns JSMN_SUCCESS.
  */
 jsmnerr_t jsmn_parse(jsmn_parser *parser, const char *js, 
 		jsmntok_t *tokens, unsigned int num_tokens);
@@ -0,0 +1,126 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#include "CppUnitTest.h"
+#include "JsonArenaParser.h"
+#include <string.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArduinoJson::Parser;
+
+namespace JsonParserTests
+{
+    TEST_CLASS(JsonTokenCountTests)
+    {
+    public:
+
+        TEST_METHOD(EmptyObject)
+        {
+            Assert::AreEqual(1, JsonParserBase::countTokens("{}"));
+        }
+
+        TEST_METHOD(NestedValues)
+        {
+            Assert::AreEqual(10, JsonParserBase::countTokens("{\"a\":[1,2,\"x\"],\"b\":{\"c\":true}}"));
+        }
+
+        TEST_METHOD(CountIsEnoughToParse)
+        {
+            char json[] = "{\"a\":[1,2,\"x\"],\"b\":{\"c\":true}}";
+            int count = JsonParserBase::countTokens(json);
+
+            jsmntok_t tokens[10];
+            JsonParserBase tooFew(tokens, count - 1);
+            JsonParserBase enough(tokens, count);
+
+            Assert::IsFalse(tooFew.parse(json).success());
+            Assert::IsTrue(enough.parse(json).success());
+        }
+
+        TEST_METHOD(StringIsNotAltered)
+        {
+            const char* json = "{\"key\":\"value\"}";
+
+            JsonParserBase::countTokens(json);
+
+            Assert::AreEqual("{\"key\":\"value\"}", json);
+        }
+
+        TEST_METHOD(IncompleteDocument)
+        {
+            Assert::AreEqual((int) JSMN_ERROR_PART, JsonParserBase::countTokens("{\"a\":[1,2"));
+        }
+
+        TEST_METHOD(UnmatchedClosingBracket)
+        {
+            Assert::AreEqual((int) JSMN_ERROR_INVAL, JsonParserBase::countTokens("[1]]"));
+        }
+    };
+
+    TEST_CLASS(JsonArenaParserTests)
+    {
+    public:
+
+        TEST_METHOD(FixedArenaLargeEnough)
+        {
+            char json[] = "{\"a\":1,\"b\":[2,3]}";
+            jsmntok_t tokens[8];
+            JsonTokenArena arena(tokens, 8);
+            JsonArenaParser parser(&arena);
+
+            JsonObject root = parser.parse(json);
+
+            Assert::IsTrue(root.success());
+            Assert::AreEqual(7, parser.getTokenCount());
+            Assert::AreEqual(3L, (long) root["b"][1]);
+        }
+
+        TEST_METHOD(FixedArenaTooSmall)
+        {
+            char json[] = "{\"a\":1,\"b\":[2,3]}";
+            jsmntok_t tokens[4];
+            JsonTokenArena arena(tokens, 4);
+            JsonArenaParser parser(&arena);
+
+            Assert::IsFalse(parser.parse(json).success());
+            Assert::AreEqual(7, parser.getTokenCount());
+        }
+
+        TEST_METHOD(HeapArenaGrows)
+        {
+            char small[] = "[1]";
+            char large[] = "[1,2,3,4,5,6,7,8,9]";
+            JsonHeapTokenArena arena(16);
+            JsonArenaParser parser(&arena);
+
+            Assert::AreEqual(1L, (long) JsonArray(parser.parse(small))[0]);
+            Assert::AreEqual(2, arena.size());
+
+            Assert::AreEqual(9L, (long) JsonArray(parser.parse(large))[8]);
+            Assert::AreEqual(10, arena.size());
+        }
+
+        TEST_METHOD(HeapArenaLimit)
+        {
+            char json[] = "[1,2,3,4,5,6,7,8,9]";
+            JsonHeapTokenArena arena(8);
+            JsonArenaParser parser(&arena);
+
+            Assert::IsFalse(parser.parse(json).success());
+            Assert::AreEqual(0, arena.size());
+        }
+
+        TEST_METHOD(InvalidDocument)
+        {
+            char json[] = "[1,2";
+            JsonHeapTokenArena arena(8);
+            JsonArenaParser parser(&arena);
+
+            Assert::IsFalse(parser.parse(json).success());
+            Assert::AreEqual(0, parser.getTokenCount());
+            Assert::AreEqual(0, arena.size());
+        }
+    };
+}
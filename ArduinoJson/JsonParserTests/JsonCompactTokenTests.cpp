@@ -0,0 +1,96 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#include "CppUnitTest.h"
+#include "JsonParser.h"
+#include <string>
+
+using namespace std;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArduinoJson::Parser;
+
+// Only built in the DebugCompact configuration
+#ifdef JSMN_COMPACT_TOKENS
+
+namespace JsonParserTests
+{
+    TEST_CLASS(JsonCompactTokenTests)
+    {
+        string json;
+        jsmntok_t tokens[2];
+
+    public:
+
+        TEST_METHOD(TokenIsEightBytes)
+        {
+            Assert::AreEqual(8, (int) sizeof(jsmntok_t));
+        }
+
+        TEST_METHOD(LongestString)
+        {
+            whenInputIsAStringArrayOfLength(65534);
+            countMustBe(2);
+            parseMustSucceed();
+
+            // the end of the document is one before JSMN_UNSET
+            Assert::AreEqual(65534, (int) tokens[0].end);
+            Assert::AreEqual(65532, (int) tokens[1].end);
+        }
+
+        TEST_METHOD(StringTooLong)
+        {
+            whenInputIsAStringArrayOfLength(65535);
+            countMustBe(JSMN_ERROR_NOMEM);
+            parseMustFail();
+        }
+
+        TEST_METHOD(LongestPadding)
+        {
+            whenInputIsAPaddedArrayOfLength(65534);
+            countMustBe(2);
+            parseMustSucceed();
+        }
+
+        TEST_METHOD(PaddingTooLong)
+        {
+            whenInputIsAPaddedArrayOfLength(65535);
+            countMustBe(JSMN_ERROR_NOMEM);
+            parseMustFail();
+        }
+
+    private:
+
+        // ["xxx...xxx"]
+        void whenInputIsAStringArrayOfLength(int length)
+        {
+            json = "[\"" + string(length - 4, 'x') + "\"]";
+        }
+
+        // [1         ...]
+        void whenInputIsAPaddedArrayOfLength(int length)
+        {
+            json = "[1" + string(length - 3, ' ') + "]";
+        }
+
+        void countMustBe(int expected)
+        {
+            Assert::AreEqual(expected, JsonParserBase::countTokens(json.c_str()));
+        }
+
+        void parseMustSucceed()
+        {
+            JsonParserBase parser(tokens, 2);
+            Assert::IsTrue(parser.parse(&json[0]).success());
+        }
+
+        void parseMustFail()
+        {
+            JsonParserBase parser(tokens, 2);
+            Assert::IsFalse(parser.parse(&json[0]).success());
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,108 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#include "CppUnitTest.h"
+#include "JsonParser.h"
+#include "JsonObjectIndex.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArduinoJson::Parser;
+
+namespace JsonParserTests
+{
+    TEST_CLASS(JsonObjectIndexTests)
+    {
+    public:
+
+        TEST_METHOD(EmptyObject)
+        {
+            char json[] = "{}";
+            JsonParser<1> parser;
+
+            JsonObjectIndex<4> index(parser.parse(json));
+
+            Assert::IsTrue(index.success());
+            Assert::AreEqual(0, index.size());
+            Assert::IsFalse(index.containsKey("key"));
+        }
+
+        TEST_METHOD(NotAnObject)
+        {
+            char json[] = "[1,2]";
+            JsonParser<3> parser;
+
+            JsonObjectIndex<4> index(parser.parse(json));
+
+            Assert::IsFalse(index.success());
+            Assert::IsFalse(index.containsKey("key"));
+        }
+
+        TEST_METHOD(ThreeValues)
+        {
+            char json[] = "{\"key1\":1,\"key2\":\"two\",\"key3\":true}";
+            JsonParser<7> parser;
+
+            JsonObjectIndex<8> index(parser.parse(json));
+
+            Assert::IsTrue(index.success());
+            Assert::AreEqual(3, index.size());
+            Assert::AreEqual(1L, (long) index["key1"]);
+            Assert::AreEqual("two", (const char*) index["key2"]);
+            Assert::IsTrue((bool) index["key3"]);
+            Assert::IsFalse(index.containsKey("key4"));
+        }
+
+        TEST_METHOD(NestedValuesAreSkipped)
+        {
+            char json[] = "{\"a\":{\"b\":1,\"c\":[1,2,3]},\"d\":{\"e\":2},\"f\":3}";
+            JsonParser<16> parser;
+
+            JsonObjectIndex<8> index(parser.parse(json));
+
+            Assert::AreEqual(3, index.size());
+            Assert::IsFalse(index.containsKey("b"));
+            Assert::IsFalse(index.containsKey("e"));
+            Assert::AreEqual(2L, (long) index["d"]["e"]);
+            Assert::AreEqual(3L, (long) index["f"]);
+
+            JsonObjectIndex<4> nested(index["a"]);
+            Assert::AreEqual(1L, (long) nested["b"]);
+            Assert::AreEqual(3L, (long) nested["c"][2]);
+        }
+
+        TEST_METHOD(DuplicateKeysKeepTheFirst)
+        {
+            char json[] = "{\"key\":1,\"key\":2}";
+            JsonParser<5> parser;
+
+            JsonObjectIndex<4> index(parser.parse(json));
+
+            Assert::AreEqual(1, index.size());
+            Assert::AreEqual(1L, (long) index["key"]);
+        }
+
+        TEST_METHOD(TooManyKeysFallsBackToScanning)
+        {
+            char json[] = "{\"key1\":1,\"key2\":2,\"key3\":3}";
+            JsonParser<7> parser;
+
+            JsonObjectIndex<2> index(parser.parse(json));
+
+            Assert::IsFalse(index.success());
+            Assert::AreEqual(3L, (long) index["key3"]);
+            Assert::IsFalse(index.containsKey("key4"));
+        }
+
+        TEST_METHOD(NullKey)
+        {
+            char json[] = "{\"key\":1}";
+            JsonParser<3> parser;
+
+            JsonObjectIndex<4> index(parser.parse(json));
+
+            Assert::IsFalse(index[(const char*) 0].success());
+        }
+    };
+}
@@ -0,0 +1,158 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#include "CppUnitTest.h"
+#include "JsonSelector.h"
+#include "JsonStreamParser.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArduinoJson::Parser;
+
+namespace JsonParserTests
+{
+    TEST_CLASS(JsonSelectorTests)
+    {
+        JsonStreamParser<8, 12> parser;
+        JsonSelector<4, 8> selector;
+
+    public:
+
+        TEST_METHOD_INITIALIZE(Initialize)
+        {
+            parser.begin(&selector);
+        }
+
+        TEST_METHOD(InvalidPaths)
+        {
+            Assert::AreEqual(-1, selector.add(""));
+            Assert::AreEqual(-1, selector.add("a..b"));
+            Assert::AreEqual(-1, selector.add("a."));
+            Assert::AreEqual(-1, selector.add("a.b.c.d.e.f.g.h.i"));
+            Assert::AreEqual(0, selector.size());
+        }
+
+        TEST_METHOD(TooManyPaths)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                Assert::AreEqual(i, selector.add("a"));
+            }
+
+            Assert::AreEqual(-1, selector.add("a"));
+        }
+
+        TEST_METHOD(NestedValues)
+        {
+            int hour = selector.add("moon_phase.sunset.hour");
+            int minute = selector.add("moon_phase.sunset.minute");
+            int phase = selector.add("moon_phase.phase");
+
+            whenInputIs("{\"moon_phase\":{\"phase\":\"Full\",\"sunset\":{\"hour\":\"17\",\"minute\":42}}}");
+
+            parseMustSucceed();
+            Assert::AreEqual(17L, selector.asLong(hour));
+            Assert::AreEqual(42L, selector.asLong(minute));
+            Assert::AreEqual("Full", selector.asString(phase));
+        }
+
+        TEST_METHOD(UnrelatedValuesAreSkipped)
+        {
+            int hour = selector.add("sunset.hour");
+
+            // the scratch of the parser only fits 12 chars
+            whenInputIs("{\"response\":{\"termsofService\":\"http://www.example.com/terms.html\"},"
+                "\"list\":[{\"hour\":1}],\"sunset\":{\"hour\":\"17\"}}");
+
+            parseMustSucceed();
+            Assert::AreEqual(17L, selector.asLong(hour));
+        }
+
+        TEST_METHOD(SameKeyAtAnotherLevel)
+        {
+            int hour = selector.add("sunset.hour");
+
+            whenInputIs("{\"hour\":1,\"sunrise\":{\"hour\":2},\"sunset\":{\"hour\":3}}");
+
+            parseMustSucceed();
+            Assert::AreEqual(3L, selector.asLong(hour));
+        }
+
+        TEST_METHOD(MissingValue)
+        {
+            int hour = selector.add("sunset.hour");
+            int minute = selector.add("sunset.minute");
+
+            whenInputIs("{\"sunset\":{\"hour\":3}}");
+
+            parseMustSucceed();
+            Assert::IsTrue(selector.found(hour));
+            Assert::IsFalse(selector.found(minute));
+            Assert::IsNull(selector.asString(minute));
+            Assert::AreEqual(0L, selector.asLong(minute));
+        }
+
+        TEST_METHOD(ContainersAreNotValues)
+        {
+            int sunset = selector.add("sunset");
+
+            whenInputIs("{\"sunset\":{\"hour\":3}}");
+
+            parseMustSucceed();
+            Assert::IsFalse(selector.found(sunset));
+        }
+
+        TEST_METHOD(ValueTooLong)
+        {
+            JsonStreamParser<4, 16> longerParser;
+            JsonSelector<1, 4> shortSelector;
+            int name = shortSelector.add("name");
+
+            longerParser.begin(&shortSelector);
+            longerParser.parse("{\"name\":\"123456\"}");
+
+            Assert::AreEqual((int) JSMN_SUCCESS, (int) longerParser.status());
+            Assert::IsFalse(shortSelector.found(name));
+        }
+
+        TEST_METHOD(DuplicateKeysKeepTheFirst)
+        {
+            int key = selector.add("key");
+
+            whenInputIs("{\"key\":1,\"key\":2}");
+
+            parseMustSucceed();
+            Assert::AreEqual(1L, selector.asLong(key));
+        }
+
+        TEST_METHOD(ResetForgetsTheValues)
+        {
+            int key = selector.add("key");
+            whenInputIs("{\"key\":1}");
+
+            selector.reset();
+            parser.begin(&selector);
+            whenInputIs("{\"other\":2}");
+
+            parseMustSucceed();
+            Assert::IsFalse(selector.found(key));
+        }
+
+    private:
+
+        void whenInputIs(const char* json)
+        {
+            // one byte at a time, as it would come from a socket
+            for (const char* c = json; *c; c++)
+            {
+                parser.parse(c, 1);
+            }
+        }
+
+        void parseMustSucceed()
+        {
+            Assert::AreEqual((int) JSMN_SUCCESS, (int) parser.status());
+        }
+    };
+}
@@ -0,0 +1,231 @@
+/*
+* Arduino JSON library
+* Benoit Blanchon 2014 - MIT License
+*/
+
+#include "CppUnitTest.h"
+#include "JsonStreamParser.h"
+#include <string>
+
+using namespace std;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArduinoJson::Parser;
+
+namespace JsonParserTests
+{
+    // Writes down every value it receives, e.g. "{a:1,b:[2,"x"]}"
+    class RecordingHandler : public JsonStreamHandler
+    {
+    public:
+        string events;
+
+        virtual bool startContainer(jsmntype_t type, const char* key)
+        {
+            writeKey(key);
+            events += (type == JSMN_OBJECT) ? "{" : "[";
+            return key == 0 || strcmp(key, "skipped") != 0;
+        }
+
+        virtual void endContainer(jsmntype_t type)
+        {
+            events += (type == JSMN_OBJECT) ? "}" : "]";
+        }
+
+        virtual void value(jsmntype_t type, const char* key, const char* text)
+        {
+            writeKey(key);
+            events += (type == JSMN_STRING) ? "\"" : "";
+            events += text;
+            events += (type == JSMN_STRING) ? "\"" : "";
+            events += ",";
+        }
+
+    private:
+        void writeKey(const char* key)
+        {
+            if (key == 0) return;
+            events += key;
+            events += ":";
+        }
+    };
+
+    TEST_CLASS(JsonStreamParserTests)
+    {
+        JsonStreamParser<4, 16> parser;
+        RecordingHandler handler;
+
+    public:
+
+        TEST_METHOD_INITIALIZE(Initialize)
+        {
+            parser.begin(&handler);
+        }
+
+        TEST_METHOD(EmptyObject)
+        {
+            whenInputIs("{}");
+            parseMustSucceed();
+            eventsMustBe("{}");
+        }
+
+        TEST_METHOD(NestedValues)
+        {
+            whenInputIs("{\"a\":1,\"b\":[true,\"x\",null],\"c\":{\"d\":-2.5}}");
+            parseMustSucceed();
+            eventsMustBe("{a:1,b:[true,\"x\",null,]c:{d:-2.5,}}");
+        }
+
+        TEST_METHOD(OneByteAtATime)
+        {
+            const char* json = "{ \"key\" : [ 12 , \"va\\\"lue\" ] }";
+
+            for (const char* c = json; c[1] != 0; c++)
+            {
+                Assert::AreEqual((int) JSMN_ERROR_PART, (int) parser.parse(c, 1));
+            }
+
+            Assert::AreEqual((int) JSMN_SUCCESS, (int) parser.parse("}"));
+            eventsMustBe("{key:[12,\"va\"lue\",]}");
+        }
+
+        TEST_METHOD(EscapedCharsAcrossChunks)
+        {
+            parser.parse("[\"1\\");
+            parser.parse("n2\\");
+            parser.parse("t3\"]");
+
+            parseMustSucceed();
+            eventsMustBe("[\"1\n2\t3\",]");
+        }
+
+        TEST_METHOD(IncompleteDocument)
+        {
+            whenInputIs("{\"key\":[1,2");
+            Assert::AreEqual((int) JSMN_ERROR_PART, (int) parser.status());
+            Assert::AreEqual(2, parser.depth());
+        }
+
+        TEST_METHOD(TopLevelNumber)
+        {
+            whenInputIs("42");
+            Assert::AreEqual((int) JSMN_ERROR_PART, (int) parser.status());
+
+            Assert::AreEqual((int) JSMN_SUCCESS, (int) parser.finish());
+            eventsMustBe("42,");
+        }
+
+        TEST_METHOD(MissingColon)
+        {
+            whenInputIs("{\"key\" 1}");
+            parseMustFailWith(JSMN_ERROR_INVAL);
+        }
+
+        TEST_METHOD(MismatchedBrackets)
+        {
+            whenInputIs("{\"key\":[1}");
+            parseMustFailWith(JSMN_ERROR_INVAL);
+        }
+
+        TEST_METHOD(TrailingComma)
+        {
+            whenInputIs("[1,]");
+            parseMustFailWith(JSMN_ERROR_INVAL);
+        }
+
+        TEST_METHOD(GarbageAfterTheDocument)
+        {
+            whenInputIs("{} x");
+            parseMustFailWith(JSMN_ERROR_INVAL);
+        }
+
+        TEST_METHOD(TooDeep)
+        {
+            whenInputIs("[[[[[1]]]]]");
+            parseMustFailWith(JSMN_ERROR_NOMEM);
+        }
+
+        TEST_METHOD(ValueTooLong)
+        {
+            whenInputIs("[\"0123456789abcdefg\"]");
+            parseMustFailWith(JSMN_ERROR_NOMEM);
+        }
+
+        TEST_METHOD(KeyOfTheLongestLength)
+        {
+            whenInputIs("{\"0123456789abcdef\":\"0123456789abcdef\"}");
+            parseMustSucceed();
+            eventsMustBe("{0123456789abcdef:\"0123456789abcdef\",}");
+        }
+
+        TEST_METHOD(SkippedContainers)
+        {
+            whenInputIs("{\"a\":1,\"skipped\":{\"b\":[\"a value that doesn't fit\",{}],\"c\":2},\"d\":[3]}");
+            parseMustSucceed();
+            eventsMustBe("{a:1,skipped:{}d:[3,]}");
+        }
+
+        TEST_METHOD(SkippedContainersAreStillChecked)
+        {
+            whenInputIs("{\"skipped\":{\"a\":[1],\"b\" 2}}");
+            parseMustFailWith(JSMN_ERROR_INVAL);
+        }
+
+        TEST_METHOD(SkippedContainersCanBeDeeperThanTheStack)
+        {
+            whenInputIs("{\"skipped\":[[[[[[1,{\"a\":[]}],\"x\"],{}]]]],\"d\":2}");
+            parseMustSucceed();
+            eventsMustBe("{skipped:[]d:2,}");
+            Assert::AreEqual(0, parser.depth());
+        }
+
+        TEST_METHOD(SkippedMembersOfAnUnknownKind)
+        {
+            whenInputIs("{\"skipped\":{\"a\":[],\"b\":{},\"c\":[[],\"x\",1]},\"d\":2}");
+            parseMustSucceed();
+            eventsMustBe("{skipped:{}d:2,}");
+        }
+
+        TEST_METHOD(ErrorsAreKept)
+        {
+            whenInputIs("[1 2");
+            parseMustFailWith(JSMN_ERROR_INVAL);
+
+            parser.parse("]");
+            parseMustFailWith(JSMN_ERROR_INVAL);
+        }
+
+        TEST_METHOD(BeginRestarts)
+        {
+            whenInputIs("[1 2");
+
+            parser.begin(&handler);
+            handler.events = "";
+            whenInputIs("[3]");
+
+            parseMustSucceed();
+            eventsMustBe("[3,]");
+        }
+
+    private:
+
+        void whenInputIs(const char* json)
+        {
+            parser.parse(json);
+        }
+
+        void parseMustSucceed()
+        {
+            Assert::AreEqual((int) JSMN_SUCCESS, (int) parser.status());
+        }
+
+        void parseMustFailWith(jsmnerr_t error)
+        {
+            Assert::AreEqual((int) error, (int) parser.status());
+        }
+
+        void eventsMustBe(const char* expected)
+        {
+            Assert::AreEqual(expected, handler.events.c_str());
+        }
+    };
+}
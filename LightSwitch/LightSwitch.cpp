@@ -5,12 +5,97 @@
 #include "SwitchScheduler.h"
 #include "JsonGenerator.h"
 #include "JsonParser.h"
+#include "PerfectHash.h"
 #include "LightSwitch.h"
 
-LightSwitch::LightSwitch(SwitchSchedulerConfiguration* config, SparkTime* rtc)
+// Configuration keys for the JSON object used to configure settings
+// remotely, in LightSwitchConfig order.
+static constexpr const char* configKeys[] =
+{
+    "IsToggled",
+    // "TimezoneOffset",
+    "SunsetApiUrl",
+    "SunsetApiCheckTime",
+    "IsSchedulerEnabled",
+    "IsHomeOnlyModeEnabled",
+    "HomeStatus",
+    "MobileId",
+    "PresenceTimeout"
+    // "OutletSwitchOffTime"
+};
+
+static constexpr int configKeysLength = sizeof(configKeys) / sizeof(configKeys[0]);
+
+// The configuration keys are looked up in a perfect hash table with twice
+// as many slots as there are keys.
+#define ConfigKeysTableSize 16
+
+static constexpr int32_t configKeysSeed =
+    PerfectHash::findSeed(configKeys, configKeysLength, ConfigKeysTableSize);
+
+static_assert(configKeysSeed != -1,
+    "No perfect hash seed for the configuration keys, grow the table.");
+static_assert(configKeysLength <= ConfigKeysTableSize / 2,
+    "Too many configuration keys for the perfect hash table.");
+
+#define ConfigKeyAt(slot) PerfectHash::keyAt(configKeys, configKeysLength, \
+    configKeysSeed, ConfigKeysTableSize, slot)
+
+// The index of the configuration key in each slot of the table, or -1.
+static const int8_t configKeySlots[ConfigKeysTableSize] =
+{
+    ConfigKeyAt(0), ConfigKeyAt(1), ConfigKeyAt(2), ConfigKeyAt(3),
+    ConfigKeyAt(4), ConfigKeyAt(5), ConfigKeyAt(6), ConfigKeyAt(7),
+    ConfigKeyAt(8), ConfigKeyAt(9), ConfigKeyAt(10), ConfigKeyAt(11),
+    ConfigKeyAt(12), ConfigKeyAt(13), ConfigKeyAt(14), ConfigKeyAt(15)
+};
+
+// The index of a configuration key, or -1 if it isn't one.
+static int findConfigKey(const char* key)
+{
+    int index = configKeySlots[
+        PerfectHash::slot(key, configKeysSeed, ConfigKeysTableSize)];
+
+    return index != -1 && strcmp(key, configKeys[index]) == 0 ? index : -1;
+}
+
+// Parses a whole JSON value as an integer. Returns false if it isn't one,
+// rather than treating it as 0 like converting the value to a long does.
+static bool parseLong(ArduinoJson::Parser::JsonValue value, long* result)
+{
+    char* text = value;
+    if (text == NULL || *text == '\0')
+    {
+        return false;
+    }
+
+    char* end;
+    *result = strtol(text, &end, 10);
+    return *end == '\0';
+}
+
+LightSwitch::LightSwitch(SwitchSchedulerConfiguration* config, SparkTime* rtc,
+    SwitchClock* clock)
 {
-    scheduler = new SwitchScheduler(config, rtc);
     this->rtc = rtc;
+    this->clock = clock != NULL ? clock : new SparkTimeClock(rtc);
+    scheduler = new SwitchScheduler(config, rtc, this->clock);
+
+    actuator = new SwitchActuator(
+        config->switchCoalesceWindow * 1000UL,
+        config->switchMinimumOnTime * 1000UL,
+        config->switchMinimumOffTime * 1000UL);
+
+    // The cloud allows a burst of 4 events and then one a second.
+    publishQueue = new PublishQueue(4, 1000, this->clock->millis());
+
+    strcpy(currentState, "{\"error\":\"not initialized\"}");
+    currentStateSourceVersion = 0;
+    currentStateMinute = -1;
+    outletSwitchStateVersion = 0;
+
+    scheduler->getFireLatencyStats()->printTo(fireLatency, sizeof(fireLatency));
+    fireLatencyCount = 0;
 }
 
 void LightSwitch::initialize()
@@ -32,6 +117,18 @@ void LightSwitch::addSchedule(SwitchSchedulerTask* task)
 void LightSwitch::tick()
 {
     scheduler->tock();
+
+    // Write the scheduler's changes once they've settled.
+    bool isToggled;
+    if (actuator->poll(clock->millis(), &isToggled))
+    {
+        writeOutletSwitch(isToggled);
+    }
+
+    publishQueue->poll(clock->millis());
+
+    printCurrentState();
+    printFireLatency();
 }
 
 void LightSwitch::setOutletSwitchPin(int pin)
@@ -40,30 +137,54 @@ void LightSwitch::setOutletSwitchPin(int pin)
 
     // Initialize pin.
     pinMode(outletSwitchPin, OUTPUT);
-    toggleOutletSwitch(false);
+    writeOutletSwitch(false);
+    actuator->reset(false, clock->millis());
 }
 
 const char* LightSwitch::getCurrentState()
 {
+    return currentState;
+}
+
+void LightSwitch::printCurrentState()
+{
+    unsigned long sourceVersion =
+        scheduler->getStateVersion() + outletSwitchStateVersion;
+    long minute = clock->nowEpoch() / 60;
+
+    if (sourceVersion == currentStateSourceVersion &&
+        minute == currentStateMinute)
+    {
+        return;
+    }
+
+    currentStateSourceVersion = sourceVersion;
+    currentStateMinute = minute;
+
     ArduinoJson::Generator::JsonObject<15> root;
     SwitchSchedulerConfiguration* config = scheduler->getConfiguration();
 
     // current time
-    String now = rtc->ISODateString(rtc->now());
-    root["time"] = now.c_str();
+    char now[ISODateMaxLength];
+    Sparky::FormatISODate(rtc, clock->nowEpoch(), now, sizeof(now));
+    root["time"] = now;
 
-    root["isDst"] = rtc->isUSDST(rtc->now());
+    root["isDst"] = rtc->isUSDST(clock->now());
 
     // switch schedules
+    // Only the first few schedules fit in the state variable.
     ArduinoJson::Generator::JsonArray<10> tasksArray;
     ArduinoJson::Generator::JsonObject<2> taskObjects[10];
-    int tasksLength = scheduler->getTasksLength();
-    SwitchSchedulerTask** tasks = scheduler->getTasks();
+    char taskTimes[10][2][SwitchSchedulerRuleMaxLength];
+    int tasksLength = min(scheduler->getTasksLength(), 10);
+    SwitchSchedulerTask* tasks = scheduler->getTasks();
 
     for (int i = 0; i < tasksLength; i++)
     {
-        taskObjects[i]["startTime"] = tasks[i]->startTime.c_str();
-        taskObjects[i]["endTime"] = tasks[i]->endTime.c_str();
+        tasks[i].startTime.toString(taskTimes[i][0], SwitchSchedulerRuleMaxLength);
+        tasks[i].endTime.toString(taskTimes[i][1], SwitchSchedulerRuleMaxLength);
+        taskObjects[i]["startTime"] = taskTimes[i][0];
+        taskObjects[i]["endTime"] = taskTimes[i][1];
         tasksArray.add(taskObjects[i]);
     }
 
@@ -71,11 +192,13 @@ const char* LightSwitch::getCurrentState()
 
     // is using astronomy data?
     // root["useAstronomyData"] = scheduler->isUsingAstronomyData();
-    String sunset = Sparky::ISODateString(rtc, scheduler->getSunsetTime());
-    root["sunsetTime"] = sunset.c_str();
+    char sunset[ISODateMaxLength];
+    Sparky::FormatISODate(rtc, scheduler->getSunsetTime(), sunset, sizeof(sunset));
+    root["sunsetTime"] = sunset;
 
-    String sunrise = Sparky::ISODateString(rtc, scheduler->getSunriseTime());
-    root["sunriseTime"] = sunrise.c_str();
+    char sunrise[ISODateMaxLength];
+    Sparky::FormatISODate(rtc, scheduler->getSunriseTime(), sunrise, sizeof(sunrise));
+    root["sunriseTime"] = sunrise;
 
     // timezone offset
     // root["timezoneOffset"] = config->timezoneOffset;
@@ -93,10 +216,24 @@ const char* LightSwitch::getCurrentState()
 
     root["currentHomeCount"] = scheduler->getCurrentHomeCount();
 
-    char buffer[StringVariableMaxLength];
-    root.printTo(buffer, sizeof(buffer));
+    root.printTo(currentState, sizeof(currentState));
+}
 
-    return String(buffer).c_str();
+const char* LightSwitch::getFireLatency()
+{
+    return fireLatency;
+}
+
+void LightSwitch::printFireLatency()
+{
+    FireLatencyStats* stats = scheduler->getFireLatencyStats();
+    if (stats->getCount() == fireLatencyCount)
+    {
+        return;
+    }
+
+    stats->printTo(fireLatency, sizeof(fireLatency));
+    fireLatencyCount = stats->getCount();
 }
 
 int LightSwitch::configureHandler(String command)
@@ -108,59 +245,140 @@ int LightSwitch::configureHandler(String command)
     ArduinoJson::Parser::JsonParser<64> parser;
     ArduinoJson::Parser::JsonObject root = parser.parse(const_cast<char*>(command.c_str()));
 
-    ArduinoJson::Parser::JsonValue value, mobileId;
-    value = root[configKeys[LightSwitchConfig::IsToggled]];
-    if (value.success())
+    if (!root.success())
     {
-        toggleOutletSwitch(value);
+        return LightSwitchConfigError::InvalidJson;
     }
 
-    // value = root[configKeys[LightSwitchConfig::TimezoneOffset]];
-    // if (value.success())
-    // {
-    //     scheduler->setTimezoneOffset(atoi(value));
-    // }
+    // Collect the settings in a single pass over the request, rather than
+    // searching it once for every key.
+    ArduinoJson::Parser::JsonValue values[configKeysLength];
+    for (ArduinoJson::Parser::JsonObjectIterator it = root.begin();
+        it != root.end(); ++it)
+    {
+        int key = findConfigKey(it.key());
+        if (key != -1)
+        {
+            values[key] = it.value();
+        }
+    }
 
-    value = root[configKeys[LightSwitchConfig::SunsetApiUrl]];
-    if (value.success())
+    // Validate every setting before applying any of them, so that a bad
+    // request doesn't leave the switch half configured.
+    ArduinoJson::Parser::JsonValue value = values[LightSwitchConfig::SunsetApiUrl];
+    if (value.success() && ((char*)value == NULL ||
+        !AstronomyDataFetcher::isValidUrl((char*)value)))
     {
-        scheduler->setAstronomyApiUrl((const char*)value);
+        return LightSwitchConfigError::InvalidField - LightSwitchConfig::SunsetApiUrl;
     }
 
-    value = root[configKeys[LightSwitchConfig::SunsetApiCheckTime]];
-    if (value.success())
+    value = values[LightSwitchConfig::SunsetApiCheckTime];
+    if (value.success() && ((char*)value == NULL ||
+        SwitchSchedulerRule::compile(value).kind != SwitchSchedulerRule::Fixed))
     {
-        scheduler->setAstronomyApiCheckTime((const char*)value);
+        return LightSwitchConfigError::InvalidField - LightSwitchConfig::SunsetApiCheckTime;
     }
 
-    value = root[configKeys[LightSwitchConfig::IsSchedulerEnabled]];
+    long presenceTimeout = 0;
+    value = values[LightSwitchConfig::PresenceTimeout];
+    if (value.success() && (!parseLong(value, &presenceTimeout) ||
+        presenceTimeout < 0 || presenceTimeout > (long)PresenceTimeoutMax))
+    {
+        return LightSwitchConfigError::InvalidField - LightSwitchConfig::PresenceTimeout;
+    }
+
+    long homeStatus = 0;
+    value = values[LightSwitchConfig::HomeStatus];
+    ArduinoJson::Parser::JsonValue mobileId = values[LightSwitchConfig::MobileId];
     if (value.success())
+    {
+        if (!parseLong(value, &homeStatus) ||
+            homeStatus < HomeStatus::Home || homeStatus > HomeStatus::Reset)
+        {
+            return LightSwitchConfigError::InvalidField - LightSwitchConfig::HomeStatus;
+        }
+
+        if (homeStatus != HomeStatus::Reset &&
+            (!mobileId.success() || (char*)mobileId == NULL ||
+                ((char*)mobileId)[0] == '\0'))
+        {
+            return LightSwitchConfigError::InvalidField - LightSwitchConfig::MobileId;
+        }
+    }
+
+    // Apply the scheduler's settings, it only re-evaluates the switch once
+    // they've all been applied.
+    SwitchSchedulerConfiguration* config = scheduler->getConfiguration();
+    int changed = 0;
+
+    scheduler->beginUpdate();
+
+    value = values[LightSwitchConfig::SunsetApiUrl];
+    if (value.success() && !(config->astronomyApiUrl == (char*)value))
+    {
+        scheduler->setAstronomyApiUrl((char*)value);
+        changed |= 1 << LightSwitchConfig::SunsetApiUrl;
+    }
+
+    value = values[LightSwitchConfig::SunsetApiCheckTime];
+    if (value.success() && !(config->astronomyApiCheckTime == (char*)value))
+    {
+        scheduler->setAstronomyApiCheckTime((char*)value);
+        changed |= 1 << LightSwitchConfig::SunsetApiCheckTime;
+    }
+
+    value = values[LightSwitchConfig::IsSchedulerEnabled];
+    if (value.success() && (bool)value != config->isEnabled)
     {
         scheduler->setIsEnabled(value);
+        changed |= 1 << LightSwitchConfig::IsSchedulerEnabled;
     }
 
-    value = root[configKeys[LightSwitchConfig::IsHomeOnlyModeEnabled]];
-    if (value.success())
+    value = values[LightSwitchConfig::IsHomeOnlyModeEnabled];
+    if (value.success() && (bool)value != config->homeOnlyModeEnabled)
     {
         scheduler->setHomeOnlyModeEnabled(value);
+        changed |= 1 << LightSwitchConfig::IsHomeOnlyModeEnabled;
     }
 
-    value = root[configKeys[LightSwitchConfig::HomeStatus]];
-    mobileId = root[configKeys[LightSwitchConfig::MobileId]];
-    if (value.success() && mobileId.success())
+    value = values[LightSwitchConfig::PresenceTimeout];
+    if (value.success() && (unsigned long)presenceTimeout != config->presenceTimeout)
     {
-        switch ((int)value)
+        scheduler->setPresenceTimeout(presenceTimeout);
+        changed |= 1 << LightSwitchConfig::PresenceTimeout;
+    }
+
+    value = values[LightSwitchConfig::HomeStatus];
+    if (value.success())
+    {
+        bool isHomeChanged = false;
+        switch (homeStatus)
         {
             case HomeStatus::Home:
-                scheduler->setHomeStatus((const char*)mobileId);
+                isHomeChanged = scheduler->setHomeStatus((char*)mobileId);
                 break;
             case HomeStatus::Away:
-                scheduler->setAwayStatus((const char*)mobileId);
+                isHomeChanged = scheduler->setAwayStatus((char*)mobileId);
                 break;
             case HomeStatus::Reset:
-                scheduler->resetHomeStatus();
+                isHomeChanged = scheduler->resetHomeStatus();
                 break;
         }
+
+        if (isHomeChanged)
+        {
+            changed |= 1 << LightSwitchConfig::HomeStatus;
+        }
+    }
+
+    scheduler->endUpdate();
+
+    // The manual toggle goes last, it overrides whatever the scheduler just
+    // requested so the switch changes at most once.
+    value = values[LightSwitchConfig::IsToggled];
+    if (value.success() && toggleOutletSwitch(value))
+    {
+        changed |= 1 << LightSwitchConfig::IsToggled;
     }
 
     // value = root[configKeys[OutletSwitchOffTime]];
@@ -175,16 +393,28 @@ int LightSwitch::configureHandler(String command)
     // mobile app should have a schedule list view
     // where schedules can be added/removed/modified
 
-    return 1;
+    return changed;
+}
+
+bool LightSwitch::toggleOutletSwitch(bool isToggled)
+{
+    if (!actuator->force(isToggled, clock->millis()))
+    {
+        return false;
+    }
+
+    writeOutletSwitch(isToggled);
+    return true;
 }
 
-void LightSwitch::toggleOutletSwitch(bool isToggled)
+void LightSwitch::writeOutletSwitch(bool isToggled)
 {
     int value = isToggled ? HIGH : LOW;
     digitalWrite(outletSwitchPin, value);
     outletSwitchState = isToggled;
-    Spark.publish("ToggleState", String(isToggled));
-    lastToggleOutletSwitchTime = rtc->now();
+    outletSwitchStateVersion++;
+    publishQueue->enqueue("ToggleState", isToggled ? "1" : "0");
+    lastToggleOutletSwitchTime = clock->now();
 }
 
 bool LightSwitch::getOutletSwitchState()
@@ -194,5 +424,5 @@ bool LightSwitch::getOutletSwitchState()
 
 void LightSwitch::schedulerCallback(SwitchSchedulerEvent::SwitchSchedulerEventEnum state)
 {
-    toggleOutletSwitch(state == SwitchSchedulerEvent::StartEvent);
+    actuator->request(state == SwitchSchedulerEvent::StartEvent, clock->millis());
 }
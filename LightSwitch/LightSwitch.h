@@ -1,4 +1,22 @@
 #include "SwitchScheduler.h"
+#include "SwitchActuator.h"
+#include "PublishQueue.h"
+#include "Sparky.h"
+
+// Errors returned by LightSwitch::configureHandler, nothing is applied when
+// one of them is returned.
+struct LightSwitchConfigError
+{
+    enum LightSwitchConfigErrorEnum
+    {
+        // The command isn't a JSON object.
+        InvalidJson = -1,
+
+        // A field has an invalid value, the key's index in configKeys is
+        // subtracted from it, e.g. -3 for an invalid SunsetApiUrl.
+        InvalidField = -2
+    };
+};
 
 struct HomeStatus
 {
@@ -13,8 +31,9 @@ struct HomeStatus
 class LightSwitch
 {
     public:
-        // ctor.
-        LightSwitch(SwitchSchedulerConfiguration*, SparkTime*);
+        // ctor, the clock defaults to the device's clock.
+        LightSwitch(SwitchSchedulerConfiguration*, SparkTime*,
+            SwitchClock* clock = NULL);
 
         // Method that configures the initial state of the app. This method
         // assumes that the parameters have been configured previously.
@@ -33,13 +52,24 @@ class LightSwitch
         // Initalize when the app turns off the outlet switch.
         // void setOutletSwitchOffTime(String timeString);
 
-        // Gets the current state of the app and sets the string variable
-        // passed in to the method.
+        // Gets the current state of the app as JSON. tick() prints it
+        // again when something in it changes, or once a minute for the
+        // time. The buffer doesn't move, so it can be registered as a cloud
+        // variable as is.
         const char* getCurrentState();
 
+        // Gets the scheduler's fire latency stats as JSON. tick() prints
+        // them again when a transition has fired. Like the state, the
+        // buffer can be registered as a cloud variable as is.
+        const char* getFireLatency();
+
         // Accepts a JSON string and parses out configuration options that
-        // can be set remotely. See configKeys for a list of settings that
-        // can be configured.
+        // can be set remotely. See configKeys in LightSwitch.cpp for a list
+        // of settings that can be configured. Every option is validated
+        // before any of them are applied, and the switch state is
+        // re-evaluated once after they all are. Returns a mask with the bit
+        // of each configKeys index whose setting changed, or a
+        // LightSwitchConfigError.
         int configureHandler(String command);
 
         // Check to see if the outlet switch needs to be turned on. If so,
@@ -51,8 +81,10 @@ class LightSwitch
         // void toggleOutletSwitchOff();
 
         // Toggle the outlet switch on or off based on the parameter. True
-        // for on, false otherwise.
-        void toggleOutletSwitch(bool isEnabled);
+        // for on, false otherwise. Takes effect right away, unlike the
+        // scheduler's changes which go through the actuator. Returns true if
+        // the switch changed.
+        bool toggleOutletSwitch(bool isEnabled);
 
         // Get the current state of the outlet switch. True for on, false
         // otherwise.
@@ -65,6 +97,31 @@ class LightSwitch
     private:
         SwitchScheduler* scheduler;
         SparkTime* rtc;
+        SwitchClock* clock;
+
+        // Decides when the scheduler's changes get written to the switch.
+        SwitchActuator* actuator;
+
+        // Sends the switch's events out at the rate the cloud accepts.
+        PublishQueue* publishQueue;
+
+        // The cloud only reads its variables between calls to loop(), so
+        // the state is printed in place without a reader seeing half of it.
+        char currentState[StringVariableMaxLength];
+
+        // The scheduler's and the switch's state versions, and the unix
+        // minute, that currentState was printed with.
+        unsigned long currentStateSourceVersion;
+        long currentStateMinute;
+
+        // Incremented whenever the outlet switch is written.
+        unsigned long outletSwitchStateVersion;
+
+        // Printed in place like currentState.
+        char fireLatency[FireLatencyMaxLength];
+
+        // The number of transitions fireLatency was printed with.
+        unsigned long fireLatencyCount;
 
         // Reference to SparkTime. Mostly using it just for the DST testing
         // capabilities.
@@ -99,6 +156,16 @@ class LightSwitch
         // Pin used to control whether the outlet switch is enabled or not.
         int outletSwitchPin;
 
+        // Writes the state to the outlet switch and queues it to be
+        // published.
+        void writeOutletSwitch(bool isToggled);
+
+        // Prints the current state again if something in it has changed.
+        void printCurrentState();
+
+        // Prints the fire latency stats again if a transition has fired.
+        void printFireLatency();
+
         // The current state of the outlet switch.
         bool outletSwitchState;
 
@@ -107,7 +174,7 @@ class LightSwitch
         // String sunsetApiUrl;
 
         // Used by the code to pull out the right configuration key from
-        // the configKeys string array.
+        // the configKeys string array in LightSwitch.cpp.
         struct LightSwitchConfig
         {
             enum LightSwitchConfigEnum
@@ -119,26 +186,12 @@ class LightSwitch
                 IsSchedulerEnabled,
                 IsHomeOnlyModeEnabled,
                 HomeStatus,
-                MobileId
+                MobileId,
+                PresenceTimeout
                 // OutletSwitchOffTime
             };
         };
 
-        // Configuration keys for the JSON object used to configure settings
-        // remotely.
-        const char* configKeys[8] =
-        {
-            "IsToggled",
-            // "TimezoneOffset",
-            "SunsetApiUrl",
-            "SunsetApiCheckTime",
-            "IsSchedulerEnabled",
-            "IsHomeOnlyModeEnabled",
-            "HomeStatus",
-            "MobileId"
-            // "OutletSwitchOffTime"
-        };
-
         // True if the app should turn on the outlet switch by using the
         // sunset time or if it should use a time specified by the
         // configuration.
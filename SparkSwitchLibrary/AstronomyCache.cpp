@@ -0,0 +1,134 @@
+#include "AstronomyCache.h"
+
+// Marks the start of a saved cache, bump the version if the layout changes.
+#define ASTRONOMY_CACHE_MAGIC 0xA5
+#define ASTRONOMY_CACHE_VERSION 1
+
+// Magic, version and the 16-bit key.
+#define ASTRONOMY_CACHE_HEADER_SIZE 4
+
+// Erased EEPROM reads as 0xFF, so that's what an empty slot looks like.
+#define ASTRONOMY_CACHE_EMPTY 0xFFFF
+
+AstronomyCache::AstronomyCache(int eepromAddress)
+{
+    this->eepromAddress = eepromAddress;
+    key = 0;
+
+    for (int i = 0; i < AstronomyCacheDays; i++)
+    {
+        entries[i].day = ASTRONOMY_CACHE_EMPTY;
+    }
+}
+
+int AstronomyCache::getSize()
+{
+    return ASTRONOMY_CACHE_HEADER_SIZE +
+        AstronomyCacheDays * sizeof(AstronomyCacheEntry);
+}
+
+void AstronomyCache::load(uint16_t key)
+{
+    this->key = key;
+
+    if (eepromAddress == -1)
+    {
+        for (int i = 0; i < AstronomyCacheDays; i++)
+        {
+            entries[i].day = ASTRONOMY_CACHE_EMPTY;
+        }
+        return;
+    }
+
+    bool isValid =
+        EEPROM.read(eepromAddress) == ASTRONOMY_CACHE_MAGIC &&
+        EEPROM.read(eepromAddress + 1) == ASTRONOMY_CACHE_VERSION &&
+        readWord(eepromAddress + 2) == key;
+
+    for (int i = 0; i < AstronomyCacheDays; i++)
+    {
+        int address = eepromAddress + ASTRONOMY_CACHE_HEADER_SIZE +
+            i * sizeof(AstronomyCacheEntry);
+
+        entries[i].day = isValid ? readWord(address) : ASTRONOMY_CACHE_EMPTY;
+        entries[i].sunriseMinute = readWord(address + 2);
+        entries[i].sunsetMinute = readWord(address + 4);
+    }
+}
+
+bool AstronomyCache::lookup(long day, int* sunriseMinute, int* sunsetMinute)
+{
+    AstronomyCacheEntry* entry = &entries[day % AstronomyCacheDays];
+
+    if (entry->day == ASTRONOMY_CACHE_EMPTY ||
+        entry->day != (uint16_t)day)
+    {
+        return false;
+    }
+
+    *sunriseMinute = entry->sunriseMinute;
+    *sunsetMinute = entry->sunsetMinute;
+    return true;
+}
+
+void AstronomyCache::store(long day, int sunriseMinute, int sunsetMinute)
+{
+    int slot = day % AstronomyCacheDays;
+    AstronomyCacheEntry* entry = &entries[slot];
+
+    entry->day = (uint16_t)day;
+    entry->sunriseMinute = sunriseMinute;
+    entry->sunsetMinute = sunsetMinute;
+
+    if (eepromAddress == -1)
+    {
+        return;
+    }
+
+    // Write the header first, in case this is the first entry with the
+    // current key. Slots saved under a different key are discarded when
+    // loading, so a stale slot can't be mistaken for this one.
+    if (EEPROM.read(eepromAddress) != ASTRONOMY_CACHE_MAGIC ||
+        EEPROM.read(eepromAddress + 1) != ASTRONOMY_CACHE_VERSION ||
+        readWord(eepromAddress + 2) != key)
+    {
+        for (int i = 0; i < AstronomyCacheDays; i++)
+        {
+            if (i != slot)
+            {
+                entries[i].day = ASTRONOMY_CACHE_EMPTY;
+                writeWord(eepromAddress + ASTRONOMY_CACHE_HEADER_SIZE +
+                    i * sizeof(AstronomyCacheEntry), ASTRONOMY_CACHE_EMPTY);
+            }
+        }
+
+        writeByte(eepromAddress, ASTRONOMY_CACHE_MAGIC);
+        writeByte(eepromAddress + 1, ASTRONOMY_CACHE_VERSION);
+        writeWord(eepromAddress + 2, key);
+    }
+
+    int address = eepromAddress + ASTRONOMY_CACHE_HEADER_SIZE +
+        slot * sizeof(AstronomyCacheEntry);
+    writeWord(address, entry->day);
+    writeWord(address + 2, entry->sunriseMinute);
+    writeWord(address + 4, entry->sunsetMinute);
+}
+
+void AstronomyCache::writeByte(int address, uint8_t value)
+{
+    if (EEPROM.read(address) != value)
+    {
+        EEPROM.write(address, value);
+    }
+}
+
+void AstronomyCache::writeWord(int address, uint16_t value)
+{
+    writeByte(address, value & 0xFF);
+    writeByte(address + 1, value >> 8);
+}
+
+uint16_t AstronomyCache::readWord(int address)
+{
+    return EEPROM.read(address) | (EEPROM.read(address + 1) << 8);
+}
@@ -0,0 +1,57 @@
+#ifndef ASTRONOMY_CACHE_H_
+#define ASTRONOMY_CACHE_H_
+
+#include "application.h"
+
+// The number of upcoming days kept in the cache.
+#define AstronomyCacheDays 8
+
+// A day's sunrise and sunset as local minutes since midnight.
+struct AstronomyCacheEntry
+{
+    // Days since the unix epoch, truncated to 16 bits.
+    uint16_t day;
+    uint16_t sunriseMinute;
+    uint16_t sunsetMinute;
+};
+
+// A fixed-size ring of sunrise and sunset times for the upcoming days,
+// persisted in the EEPROM so it survives reboots. Each day goes into the
+// slot of its day number modulo the number of days, so a window of
+// consecutive days never collides.
+class AstronomyCache
+{
+    public:
+        // ctor, the cache is stored in the EEPROM starting at the address,
+        // or only kept in memory if the address is -1.
+        AstronomyCache(int eepromAddress);
+
+        // Loads the cache from the EEPROM. The key identifies where the
+        // times came from, e.g. the location, a cache saved with a
+        // different key is discarded.
+        void load(uint16_t key);
+
+        // Gets a day's times. Returns false if the day isn't cached.
+        bool lookup(long day, int* sunriseMinute, int* sunsetMinute);
+
+        // Saves a day's times, replacing the day in the same slot.
+        void store(long day, int sunriseMinute, int sunsetMinute);
+
+        // The number of bytes the cache takes up in the EEPROM.
+        static int getSize();
+    private:
+        int eepromAddress;
+
+        uint16_t key;
+
+        AstronomyCacheEntry entries[AstronomyCacheDays];
+
+        // Writes a byte to the EEPROM if it has changed, to spare the flash.
+        void writeByte(int address, uint8_t value);
+
+        void writeWord(int address, uint16_t value);
+
+        uint16_t readWord(int address);
+};
+
+#endif // ASTRONOMY_CACHE_H_
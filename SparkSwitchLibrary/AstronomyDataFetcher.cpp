@@ -0,0 +1,323 @@
+#include "SparkDebug.h"
+#include "AstronomyDataFetcher.h"
+#include "Uri.h"
+
+AstronomyDataFetcher::AstronomyDataFetcher()
+{
+    state = AstronomyFetchState::Idle;
+    attempts = 0;
+    deadline = 0;
+    isResolved = false;
+    sunriseHour = sunriseMinute = 0;
+    sunsetHour = sunsetMinute = 0;
+
+    sunsetHourPath = selector.add("moon_phase.sunset.hour");
+    sunsetMinutePath = selector.add("moon_phase.sunset.minute");
+    sunriseHourPath = selector.add("moon_phase.sunrise.hour");
+    sunriseMinutePath = selector.add("moon_phase.sunrise.minute");
+}
+
+bool AstronomyDataFetcher::start(String url)
+{
+    if (isBusy() || attempts >= maxAttempts || !isValidUrl(url))
+    {
+        return false;
+    }
+
+    if (!(url == this->url))
+    {
+        isResolved = false;
+    }
+
+    this->url = url;
+    state = AstronomyFetchState::Resolve;
+    return true;
+}
+
+bool AstronomyDataFetcher::isValidUrl(String url)
+{
+    // The same parse resolve() uses to find the host and port.
+    Uri uri = Uri::Parse(url);
+    if (!(uri.Protocol == "http://") || uri.Host.length() == 0)
+    {
+        return false;
+    }
+
+    if (uri.Port.length() == 0)
+    {
+        return true;
+    }
+
+    long port = 0;
+    for (unsigned int i = 0; i < uri.Port.length(); i++)
+    {
+        char c = uri.Port[i];
+        if (c < '0' || c > '9' || (port = port * 10 + (c - '0')) > 65535)
+        {
+            return false;
+        }
+    }
+
+    return port > 0;
+}
+
+bool AstronomyDataFetcher::isBusy()
+{
+    return state != AstronomyFetchState::Idle;
+}
+
+void AstronomyDataFetcher::resetAttempts()
+{
+    attempts = 0;
+}
+
+AstronomyFetchState::AstronomyFetchStateEnum AstronomyDataFetcher::getState()
+{
+    return state;
+}
+
+int AstronomyDataFetcher::getSunriseHour()
+{
+    return sunriseHour;
+}
+
+int AstronomyDataFetcher::getSunriseMinute()
+{
+    return sunriseMinute;
+}
+
+int AstronomyDataFetcher::getSunsetHour()
+{
+    return sunsetHour;
+}
+
+int AstronomyDataFetcher::getSunsetMinute()
+{
+    return sunsetMinute;
+}
+
+bool AstronomyDataFetcher::step(unsigned long now)
+{
+    switch (state)
+    {
+        case AstronomyFetchState::Resolve:
+            resolve(now);
+            break;
+        case AstronomyFetchState::Connect:
+            connect(now);
+            break;
+        case AstronomyFetchState::Send:
+            send(now);
+            break;
+        case AstronomyFetchState::Read:
+            read(now);
+            break;
+        case AstronomyFetchState::Parse:
+            return parse(now);
+        case AstronomyFetchState::Backoff:
+            if ((long)(now - deadline) >= 0)
+            {
+                state = AstronomyFetchState::Resolve;
+            }
+            break;
+        default:
+            break;
+    }
+
+    return false;
+}
+
+void AstronomyDataFetcher::resolve(unsigned long now)
+{
+    Uri uri = Uri::Parse(url);
+    host = uri.Host;
+    path = uri.Path.length() > 0 ? uri.Path : String("/");
+    if (uri.QueryString.length() > 0)
+    {
+        path += "?" + uri.QueryString;
+    }
+    port = uri.Port.length() > 0 ? atoi(uri.Port.c_str()) : 80;
+
+    attempts++;
+
+    if (!isResolved)
+    {
+        DEBUG_PRINT("Resolving astronomy API host...\n");
+
+        // Blocks for up to the CC3000's DNS timeout.
+        uint32_t address = 0;
+        if (gethostbyname((char*)host.c_str(), host.length(), &address) <= 0)
+        {
+            DEBUG_PRINT("Failed to resolve astronomy API host.\n");
+            fail(now);
+            return;
+        }
+
+        ip = IPAddress(address >> 24, address >> 16, address >> 8, address);
+        isResolved = true;
+    }
+
+    state = AstronomyFetchState::Connect;
+}
+
+void AstronomyDataFetcher::connect(unsigned long now)
+{
+    DEBUG_PRINT("Connecting to astronomy API...\n");
+
+    // Blocks for up to the CC3000's connect timeout.
+    if (!client.connect(ip, port))
+    {
+        DEBUG_PRINT("Failed to connect to astronomy API.\n");
+
+        // The host may have moved, look it up again on the next attempt.
+        isResolved = false;
+        fail(now);
+        return;
+    }
+
+    state = AstronomyFetchState::Send;
+}
+
+void AstronomyDataFetcher::send(unsigned long now)
+{
+    // HTTP/1.0 so the response isn't chunked.
+    client.print("GET ");
+    client.print(path.c_str());
+    client.print(" HTTP/1.0\r\nHost: ");
+    client.print(host.c_str());
+    client.print("\r\nConnection: close\r\n\r\n");
+
+    statusCode = 0;
+    statusField = 0;
+    isInStatusLine = true;
+    isInBody = false;
+    isCurrentLineBlank = true;
+    selector.reset();
+    parser.begin(&selector);
+
+    deadline = now + readTimeout;
+    state = AstronomyFetchState::Read;
+}
+
+void AstronomyDataFetcher::read(unsigned long now)
+{
+    for (int i = 0; i < maxBytesPerStep && client.available(); i++)
+    {
+        if (!readChar(client.read()))
+        {
+            DEBUG_PRINT("Failed to parse the astronomy API response.\n");
+            client.stop();
+            fail(now);
+            return;
+        }
+    }
+
+    if (!client.connected() && !client.available())
+    {
+        client.stop();
+        state = AstronomyFetchState::Parse;
+    }
+    else if ((long)(now - deadline) >= 0)
+    {
+        DEBUG_PRINT("Timed out reading the astronomy API response.\n");
+        client.stop();
+        fail(now);
+    }
+}
+
+bool AstronomyDataFetcher::readChar(char c)
+{
+    if (isInBody)
+    {
+        jsmnerr_t result = parser.parse(&c, 1);
+        return result == JSMN_SUCCESS || result == JSMN_ERROR_PART;
+    }
+
+    // The status code is the second field of the status line.
+    if (isInStatusLine)
+    {
+        if (c == '\n')
+        {
+            isInStatusLine = false;
+            isCurrentLineBlank = true;
+        }
+        else if (c == ' ')
+        {
+            statusField++;
+        }
+        else if (statusField == 1 && c >= '0' && c <= '9')
+        {
+            statusCode = statusCode * 10 + (c - '0');
+        }
+
+        return true;
+    }
+
+    // The body starts after the first blank line.
+    if (c == '\n')
+    {
+        isInBody = isCurrentLineBlank;
+        isCurrentLineBlank = true;
+    }
+    else if (c != '\r')
+    {
+        isCurrentLineBlank = false;
+    }
+
+    return true;
+}
+
+bool AstronomyDataFetcher::parse(unsigned long now)
+{
+    if (statusCode != 200)
+    {
+        DEBUG_PRINT("Failed to retrieve sunset data with status: ");
+        DEBUG_PRINT(statusCode);
+        DEBUG_PRINT("\n");
+        fail(now);
+        return false;
+    }
+
+    if (parser.status() != JSMN_SUCCESS || !selector.found(sunsetHourPath) ||
+        !selector.found(sunsetMinutePath) || !selector.found(sunriseHourPath) ||
+        !selector.found(sunriseMinutePath))
+    {
+        DEBUG_PRINT("Failed to parse the astronomy API response.\n");
+        fail(now);
+        return false;
+    }
+
+    sunsetHour = selector.asLong(sunsetHourPath);
+    sunsetMinute = selector.asLong(sunsetMinutePath);
+    sunriseHour = selector.asLong(sunriseHourPath);
+    sunriseMinute = selector.asLong(sunriseMinutePath);
+
+    state = AstronomyFetchState::Idle;
+    return true;
+}
+
+void AstronomyDataFetcher::fail(unsigned long now)
+{
+    if (attempts >= maxAttempts)
+    {
+        DEBUG_PRINT("Giving up on the astronomy API until tomorrow.\n");
+        state = AstronomyFetchState::Idle;
+        return;
+    }
+
+    // Exponential backoff with up to 50% jitter, so a fleet of devices
+    // doesn't retry in lockstep.
+    unsigned long backoff = initialBackoff << (attempts - 1);
+    if (backoff > maxBackoff || attempts > 16)
+    {
+        backoff = maxBackoff;
+    }
+    backoff += random(backoff / 2);
+
+    DEBUG_PRINT("Retrying astronomy API in ");
+    DEBUG_PRINT(backoff / 1000);
+    DEBUG_PRINT(" seconds.\n");
+
+    deadline = now + backoff;
+    state = AstronomyFetchState::Backoff;
+}
@@ -0,0 +1,158 @@
+#ifndef ASTRONOMY_DATA_FETCHER_H_
+#define ASTRONOMY_DATA_FETCHER_H_
+
+#include "application.h"
+#include "JsonSelector.h"
+#include "JsonStreamParser.h"
+
+// How deep the astronomy API's JSON response is nested.
+#define AstronomyResponseMaxDepth 8
+
+// Large enough for the keys and values the selector doesn't skip.
+#define AstronomyResponseTextMaxLength 32
+
+// Large enough for an hour or a minute.
+#define AstronomyValueMaxLength 4
+
+struct AstronomyFetchState
+{
+    enum AstronomyFetchStateEnum
+    {
+        Idle,
+        Resolve,
+        Connect,
+        Send,
+        Read,
+        Parse,
+        Backoff
+    };
+};
+
+// Retrieves the sunrise and sunset times from the astronomy API a step at a
+// time, so the fetch can be driven from the Spark loop. Failed attempts are
+// retried with an exponential backoff, up to a maximum number of attempts a
+// day.
+//
+// Most steps don't block. The CC3000 only offers blocking calls to look a
+// host up and to open a connection, so those two get a step each: the
+// lookup blocks for up to the CC3000's DNS timeout and the connection for
+// up to its connect timeout, a few seconds each when the API can't be
+// reached. The host's address is cached, so the lookup is only done again
+// when the url changes or the address stops working.
+class AstronomyDataFetcher
+{
+    public:
+        // ctor
+        AstronomyDataFetcher();
+
+        // Starts retrieving the astronomy data from the url. Returns false
+        // if a retrieval is already in progress or there are no attempts
+        // left today, or the url isn't valid.
+        bool start(String url);
+
+        // True if the url is one that start() can retrieve, an http url
+        // with a host and an optional numeric port.
+        static bool isValidUrl(String url);
+
+        // Advances the retrieval by one step. Returns true when new
+        // astronomy data has been parsed.
+        bool step(unsigned long now);
+
+        // True while a retrieval is in progress, including the time spent
+        // waiting to retry.
+        bool isBusy();
+
+        // Allows the maximum number of attempts again, called once a day.
+        void resetAttempts();
+
+        AstronomyFetchState::AstronomyFetchStateEnum getState();
+
+        int getSunriseHour();
+
+        int getSunriseMinute();
+
+        int getSunsetHour();
+
+        int getSunsetMinute();
+    private:
+        // How many times a day the retrieval is attempted.
+        const int maxAttempts = 6;
+
+        // How long to wait before the first retry, doubled on every retry.
+        const unsigned long initialBackoff = (5 * 1000); // 5 seconds
+
+        // The longest time to wait between retries.
+        const unsigned long maxBackoff = (10 * 60 * 1000); // 10 minutes
+
+        // How long the API has to respond once the request is sent.
+        const unsigned long readTimeout = (15 * 1000); // 15 seconds
+
+        // The most bytes read from the socket in a single step.
+        const int maxBytesPerStep = 128;
+
+        AstronomyFetchState::AstronomyFetchStateEnum state;
+
+        TCPClient client;
+
+        String url;
+
+        String host;
+
+        // The address host was resolved to, valid while isResolved is set.
+        IPAddress ip;
+        bool isResolved;
+
+        String path;
+
+        int port;
+
+        // Attempts made since the last call to resetAttempts().
+        int attempts;
+
+        // When the current state times out, or when to retry while backing
+        // off, in millis().
+        unsigned long deadline;
+
+        // Parsing state of the HTTP response.
+        int statusCode;
+        int statusField;
+        bool isInStatusLine;
+        bool isInBody;
+        bool isCurrentLineBlank;
+
+        // The body is parsed as it's read, keeping only the four times
+        // rather than the whole response.
+        ArduinoJson::Parser::JsonStreamParser<AstronomyResponseMaxDepth,
+            AstronomyResponseTextMaxLength> parser;
+        ArduinoJson::Parser::JsonSelector<4, AstronomyValueMaxLength> selector;
+
+        // Indexes of the paths in the selector.
+        int sunriseHourPath;
+        int sunriseMinutePath;
+        int sunsetHourPath;
+        int sunsetMinutePath;
+
+        int sunriseHour;
+        int sunriseMinute;
+        int sunsetHour;
+        int sunsetMinute;
+
+        // Looks the host up, unless its address is cached.
+        void resolve(unsigned long now);
+
+        void connect(unsigned long now);
+
+        void send(unsigned long now);
+
+        void read(unsigned long now);
+
+        bool parse(unsigned long now);
+
+        // Handles a failed attempt by scheduling a retry or giving up.
+        void fail(unsigned long now);
+
+        // Processes one character of the HTTP response.
+        bool readChar(char c);
+};
+
+#endif // ASTRONOMY_DATA_FETCHER_H_
@@ -0,0 +1,130 @@
+#include "FireLatencyStats.h"
+
+FireLatencyStats::FireLatencyStats()
+{
+    clear();
+}
+
+void FireLatencyStats::record(time_t planned, time_t actual)
+{
+    samples[samplesHead].planned = planned;
+    samples[samplesHead].actual = actual;
+    samplesHead = (samplesHead + 1) % FireLatencySamples;
+
+    long latency = actual > planned ? actual - planned : 0;
+
+    if (count == 0 || latency < min)
+    {
+        min = latency;
+    }
+
+    if (count == 0 || latency > max)
+    {
+        max = latency;
+    }
+
+    count++;
+    sum += latency;
+
+    int bucket = latency < FireLatencyHistogramBuckets ?
+        latency : FireLatencyHistogramBuckets - 1;
+
+    // Halve the histogram rather than let a bucket overflow, it keeps the
+    // shape of the distribution.
+    if (histogram[bucket] == 0xFFFF)
+    {
+        for (int i = 0; i < FireLatencyHistogramBuckets; i++)
+        {
+            histogram[i] >>= 1;
+        }
+    }
+    histogram[bucket]++;
+}
+
+void FireLatencyStats::clear()
+{
+    samplesHead = 0;
+    count = 0;
+    min = 0;
+    max = 0;
+    sum = 0;
+
+    for (int i = 0; i < FireLatencySamples; i++)
+    {
+        samples[i].planned = 0;
+        samples[i].actual = 0;
+    }
+
+    for (int i = 0; i < FireLatencyHistogramBuckets; i++)
+    {
+        histogram[i] = 0;
+    }
+}
+
+unsigned long FireLatencyStats::getCount()
+{
+    return count;
+}
+
+long FireLatencyStats::getMin()
+{
+    return min;
+}
+
+long FireLatencyStats::getMax()
+{
+    return max;
+}
+
+long FireLatencyStats::getP99()
+{
+    unsigned long total = 0;
+    for (int i = 0; i < FireLatencyHistogramBuckets; i++)
+    {
+        total += histogram[i];
+    }
+
+    // The first bucket that 99% of the transitions fall within.
+    unsigned long seen = 0;
+    for (int i = 0; i < FireLatencyHistogramBuckets; i++)
+    {
+        seen += histogram[i];
+        if (seen > 0 && seen * 100 >= total * 99)
+        {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+long FireLatencyStats::getAverageMillis()
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    // Split up so the sum doesn't overflow when it's multiplied.
+    return (sum / count) * 1000 + ((sum % count) * 1000) / count;
+}
+
+bool FireLatencyStats::getSample(int index, FireLatencySample* sample)
+{
+    if (index < 0 || index >= FireLatencySamples || (unsigned long)index >= count)
+    {
+        return false;
+    }
+
+    *sample = samples[(samplesHead - 1 - index + FireLatencySamples) % FireLatencySamples];
+    return true;
+}
+
+void FireLatencyStats::printTo(char* buffer, size_t length)
+{
+    long average = getAverageMillis();
+
+    snprintf(buffer, length,
+        "{\"n\":%lu,\"min\":%ld,\"avg\":%ld.%03ld,\"max\":%ld,\"p99\":%ld}",
+        count, min, average / 1000, average % 1000, max, getP99());
+}
@@ -0,0 +1,74 @@
+#ifndef FIRE_LATENCY_STATS_H_
+#define FIRE_LATENCY_STATS_H_
+
+#include "application.h"
+
+// The number of recent transitions kept.
+#define FireLatencySamples 32
+
+// One bucket per second of latency, the last one holds everything later.
+#define FireLatencyHistogramBuckets 64
+
+// Large enough for the JSON printed by printTo().
+#define FireLatencyMaxLength 64
+
+// When a transition was planned to fire and when it actually did.
+struct FireLatencySample
+{
+    // Unix timestamps.
+    time_t planned;
+    time_t actual;
+};
+
+// Measures how late scheduled transitions fire. The most recent ones are
+// kept in a ring buffer, and the min, average, max and 99th percentile
+// are kept over every transition since start up, the percentile from a
+// histogram so recording a transition takes constant time.
+class FireLatencyStats
+{
+    public:
+        // ctor
+        FireLatencyStats();
+
+        // Records a transition.
+        void record(time_t planned, time_t actual);
+
+        // Forgets every transition.
+        void clear();
+
+        // The number of transitions recorded since start up.
+        unsigned long getCount();
+
+        // Latencies in seconds.
+        long getMin();
+        long getMax();
+        long getP99();
+
+        // The average latency in milliseconds.
+        long getAverageMillis();
+
+        // Gets one of the recent transitions, 0 being the latest. Returns
+        // false if there aren't that many.
+        bool getSample(int index, FireLatencySample* sample);
+
+        // Prints the stats as JSON, e.g.
+        // {"n":12,"min":0,"avg":0.500,"max":2,"p99":2}
+        void printTo(char* buffer, size_t length);
+    private:
+        FireLatencySample samples[FireLatencySamples];
+
+        // Where the next sample goes.
+        int samplesHead;
+
+        unsigned long count;
+
+        long min;
+
+        long max;
+
+        unsigned long sum;
+
+        uint16_t histogram[FireLatencyHistogramBuckets];
+};
+
+#endif // FIRE_LATENCY_STATS_H_
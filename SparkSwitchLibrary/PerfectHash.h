@@ -0,0 +1,93 @@
+#ifndef PERFECT_HASH_H_
+#define PERFECT_HASH_H_
+
+#include "application.h"
+
+// Perfect hashing of a small, fixed set of keys, worked out at compile
+// time. Every key hashes to a slot of its own in a table, so looking up a
+// string takes one hash and one strcmp however many keys there are. The
+// keys have to be a constexpr array of string literals.
+class PerfectHash
+{
+    public:
+        // The largest seed searched for before giving up.
+        static constexpr uint32_t MaxSeed = 255;
+
+        // FNV-1a's 32-bit offset basis and prime.
+        static constexpr uint32_t FnvOffsetBasis = 2166136261UL;
+        static constexpr uint32_t FnvPrime = 16777619UL;
+
+        // FNV-1a of a string. It can start from a seed rather than the
+        // usual offset basis, so different seeds spread the keys
+        // differently. Also used to hash strings at run time.
+        static constexpr uint32_t hash(const char* key,
+            uint32_t seed = FnvOffsetBasis)
+        {
+            return *key == '\0' ? seed :
+                hash(key + 1, (seed ^ (uint8_t)*key) * FnvPrime);
+        }
+
+        // FNV-1a of a number of bytes, which may include zeros.
+        static constexpr uint32_t hash(const uint8_t* bytes, size_t length,
+            uint32_t seed = FnvOffsetBasis)
+        {
+            return length == 0 ? seed :
+                hash(bytes + 1, length - 1, (seed ^ *bytes) * FnvPrime);
+        }
+
+        // Folds the high bits of a hash into the low ones.
+        static constexpr uint32_t fold(uint32_t hash)
+        {
+            return hash ^ (hash >> 16);
+        }
+
+        // The slot a key hashes to in a table of a size. The low bits of
+        // FNV-1a only depend on the low bits of the seed and the key, so
+        // the high bits are folded in.
+        static constexpr uint8_t slot(const char* key, uint32_t seed,
+            uint8_t tableSize)
+        {
+            return fold(hash(key, FnvOffsetBasis ^ (seed * 2654435761UL))) %
+                tableSize;
+        }
+
+        // The first seed up from a seed that hashes every key to a slot
+        // of its own, or -1 if there isn't one up to MaxSeed.
+        static constexpr int32_t findSeed(const char* const* keys,
+            int length, uint8_t tableSize, uint32_t seed = 0)
+        {
+            return seed > MaxSeed ? -1 :
+                isPerfect(keys, length, seed, tableSize, 0) ? (int32_t)seed :
+                findSeed(keys, length, tableSize, seed + 1);
+        }
+
+        // The index of the key that hashes to a slot, or -1 if none of
+        // them do.
+        static constexpr int8_t keyAt(const char* const* keys, int length,
+            uint32_t seed, uint8_t tableSize, uint8_t tableSlot, int i = 0)
+        {
+            return i == length ? -1 :
+                slot(keys[i], seed, tableSize) == tableSlot ? i :
+                keyAt(keys, length, seed, tableSize, tableSlot, i + 1);
+        }
+    private:
+        // True if no key from i on shares its slot with a later key.
+        static constexpr bool isPerfect(const char* const* keys, int length,
+            uint32_t seed, uint8_t tableSize, int i)
+        {
+            return i == length ||
+                (!collides(keys, length, seed, tableSize, i, i + 1) &&
+                    isPerfect(keys, length, seed, tableSize, i + 1));
+        }
+
+        // True if key i shares its slot with a key from j on.
+        static constexpr bool collides(const char* const* keys, int length,
+            uint32_t seed, uint8_t tableSize, int i, int j)
+        {
+            return j < length &&
+                (slot(keys[i], seed, tableSize) == slot(keys[j], seed, tableSize) ||
+                    collides(keys, length, seed, tableSize, i, j + 1));
+        }
+};
+
+#endif // PERFECT_HASH_H_
@@ -0,0 +1,193 @@
+#include "PresenceSet.h"
+#include "PerfectHash.h"
+
+#define PRESENCE_SET_EMPTY 0
+#define PRESENCE_SET_TOMBSTONE 0xFF
+
+PresenceSet::PresenceSet()
+{
+    clear();
+}
+
+int PresenceSet::add(const char* id)
+{
+    if (id == NULL || *id == '\0')
+    {
+        return -1;
+    }
+
+    uint32_t hash = Hash(id);
+    int slot = findSlot(id, hash);
+    if (slot != -1)
+    {
+        return slots[slot] - 1;
+    }
+
+    if (freeHandlesLength == 0 || strlen(id) > PresenceSetIdMaxLength)
+    {
+        return -1;
+    }
+
+    int handle = freeHandles[--freeHandlesLength];
+    strcpy(ids[handle], id);
+    hashes[handle] = hash;
+    insertSlot(handle);
+    idsLength++;
+
+    return handle;
+}
+
+int PresenceSet::find(const char* id)
+{
+    if (id == NULL)
+    {
+        return -1;
+    }
+
+    int slot = findSlot(id, Hash(id));
+    return slot == -1 ? -1 : slots[slot] - 1;
+}
+
+bool PresenceSet::remove(const char* id)
+{
+    int handle = find(id);
+    if (handle == -1)
+    {
+        return false;
+    }
+
+    remove(handle);
+    return true;
+}
+
+void PresenceSet::remove(int handle)
+{
+    if (handle < 0 || handle >= PresenceSetCapacity || ids[handle][0] == '\0')
+    {
+        return;
+    }
+
+    // The handle's slot is always before the first empty one on its probe
+    // sequence, but cap the probes in case the table is corrupt.
+    uint32_t mask = PresenceSetSlots - 1;
+    uint32_t i = hashes[handle] & mask;
+    int probes = 0;
+    for (; probes < PresenceSetSlots; probes++, i = (i + 1) & mask)
+    {
+        if (slots[i] == PRESENCE_SET_EMPTY || slots[i] == handle + 1)
+        {
+            break;
+        }
+    }
+
+    if (probes == PresenceSetSlots || slots[i] == PRESENCE_SET_EMPTY)
+    {
+        return;
+    }
+
+    slots[i] = PRESENCE_SET_TOMBSTONE;
+    ids[handle][0] = '\0';
+    freeHandles[freeHandlesLength++] = handle;
+    idsLength--;
+    tombstonesLength++;
+
+    // Tombstones make misses probe further, clean them up once they take
+    // up a quarter of the table.
+    if (idsLength == 0)
+    {
+        memset(slots, PRESENCE_SET_EMPTY, sizeof(slots));
+        tombstonesLength = 0;
+    }
+    else if (tombstonesLength > PresenceSetSlots / 4)
+    {
+        rehash();
+    }
+}
+
+const char* PresenceSet::get(int handle)
+{
+    return ids[handle];
+}
+
+void PresenceSet::clear()
+{
+    memset(slots, PRESENCE_SET_EMPTY, sizeof(slots));
+    idsLength = 0;
+    tombstonesLength = 0;
+
+    for (int i = 0; i < PresenceSetCapacity; i++)
+    {
+        ids[i][0] = '\0';
+        freeHandles[i] = PresenceSetCapacity - 1 - i;
+    }
+    freeHandlesLength = PresenceSetCapacity;
+}
+
+int PresenceSet::length()
+{
+    return idsLength;
+}
+
+int PresenceSet::findSlot(const char* id, uint32_t hash)
+{
+    uint32_t mask = PresenceSetSlots - 1;
+    uint32_t i = hash & mask;
+
+    // The table is never more than half full, so there's always an empty
+    // slot to stop at, but cap the probes in case it's all tombstones.
+    for (int probes = 0; probes < PresenceSetSlots; probes++, i = (i + 1) & mask)
+    {
+        uint8_t slot = slots[i];
+        if (slot == PRESENCE_SET_EMPTY)
+        {
+            break;
+        }
+
+        if (slot != PRESENCE_SET_TOMBSTONE && hashes[slot - 1] == hash &&
+            strcmp(ids[slot - 1], id) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void PresenceSet::insertSlot(int handle)
+{
+    uint32_t mask = PresenceSetSlots - 1;
+    for (uint32_t i = hashes[handle] & mask; ; i = (i + 1) & mask)
+    {
+        if (slots[i] == PRESENCE_SET_EMPTY)
+        {
+            slots[i] = handle + 1;
+            return;
+        }
+
+        if (slots[i] == PRESENCE_SET_TOMBSTONE)
+        {
+            slots[i] = handle + 1;
+            tombstonesLength--;
+            return;
+        }
+    }
+}
+
+void PresenceSet::rehash()
+{
+    memset(slots, PRESENCE_SET_EMPTY, sizeof(slots));
+    tombstonesLength = 0;
+
+    for (int handle = 0; handle < PresenceSetCapacity; handle++)
+    {
+        if (ids[handle][0] != '\0')
+        {
+            insertSlot(handle);
+        }
+    }
+}
+
+uint32_t PresenceSet::Hash(const char* id)
+{
+    return PerfectHash::hash(id);
+}
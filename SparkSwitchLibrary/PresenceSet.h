@@ -0,0 +1,78 @@
+#ifndef PRESENCE_SET_H_
+#define PRESENCE_SET_H_
+
+#include "application.h"
+
+// The most mobile ids that can be home at once.
+#define PresenceSetCapacity 16
+
+// Long enough for a UUID.
+#define PresenceSetIdMaxLength 40
+
+// Twice the capacity keeps the probe sequences short, must be a power of 2.
+#define PresenceSetSlots 32
+
+// The set of mobile ids that are home. Ids are copied into the set's own
+// storage, so callers can pass buffers that go away afterwards. Lookups
+// hash into an open-addressing table of indexes into that storage, so
+// adding, removing and counting ids take constant time.
+class PresenceSet
+{
+    public:
+        // ctor
+        PresenceSet();
+
+        // Adds an id. Returns its handle, which stays the same until it's
+        // removed, or -1 if the set is full or the id is empty or too long.
+        int add(const char* id);
+
+        // Gets the handle of an id, or -1 if it isn't in the set.
+        int find(const char* id);
+
+        // Removes an id. Returns false if it wasn't in the set.
+        bool remove(const char* id);
+
+        // Removes the id with the handle. Does nothing if the handle isn't
+        // in use.
+        void remove(int handle);
+
+        // Gets the id with the handle.
+        const char* get(int handle);
+
+        // Removes all of the ids.
+        void clear();
+
+        // The number of ids in the set.
+        int length();
+    private:
+        // The interned ids, indexed by handle.
+        char ids[PresenceSetCapacity][PresenceSetIdMaxLength + 1];
+
+        uint32_t hashes[PresenceSetCapacity];
+
+        // Handles that aren't in use.
+        uint8_t freeHandles[PresenceSetCapacity];
+
+        int freeHandlesLength;
+
+        // The open-addressing table, each slot is empty, a tombstone or a
+        // handle + 1.
+        uint8_t slots[PresenceSetSlots];
+
+        int idsLength;
+
+        int tombstonesLength;
+
+        // Finds the slot of an id, or -1 if it isn't in the set.
+        int findSlot(const char* id, uint32_t hash);
+
+        // Puts a handle into the first free slot of its probe sequence.
+        void insertSlot(int handle);
+
+        // Rebuilds the table without its tombstones.
+        void rehash();
+
+        static uint32_t Hash(const char* id);
+};
+
+#endif // PRESENCE_SET_H_
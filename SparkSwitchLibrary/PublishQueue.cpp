@@ -0,0 +1,109 @@
+#include "PublishQueue.h"
+
+PublishQueue::PublishQueue(uint8_t tokenCapacity, unsigned long tokenInterval,
+    unsigned long now)
+{
+    this->tokenCapacity = tokenCapacity;
+    this->tokenInterval = tokenInterval;
+    tokens = tokenCapacity;
+    refilledAt = now;
+    droppedCount = 0;
+
+    clear();
+}
+
+bool PublishQueue::enqueue(const char* name, const char* data)
+{
+    size_t dataLength = strlen(data);
+    if (strlen(name) >= PublishQueueNameMaxLength ||
+        dataLength >= PublishQueueDataMaxLength)
+    {
+        return false;
+    }
+
+    // Batch it into the newest waiting event with the same name, if the
+    // data still fits.
+    for (int i = count - 1; i >= 0; i--)
+    {
+        PublishQueueEvent* event = &events[(head + i) % PublishQueueCapacity];
+        if (strcmp(event->name, name) != 0)
+        {
+            continue;
+        }
+
+        size_t length = strlen(event->data);
+        if (length + 1 + dataLength < PublishQueueDataMaxLength)
+        {
+            event->data[length] = ',';
+            strcpy(event->data + length + 1, data);
+            return true;
+        }
+
+        break;
+    }
+
+    if (count == PublishQueueCapacity)
+    {
+        droppedCount++;
+        return false;
+    }
+
+    PublishQueueEvent* event = &events[(head + count) % PublishQueueCapacity];
+    strcpy(event->name, name);
+    strcpy(event->data, data);
+    count++;
+
+    return true;
+}
+
+void PublishQueue::poll(unsigned long now)
+{
+    refill(now);
+
+    while (count > 0 && tokens > 0)
+    {
+        PublishQueueEvent* event = &events[head];
+        Spark.publish(event->name, event->data);
+
+        head = (head + 1) % PublishQueueCapacity;
+        count--;
+        tokens--;
+    }
+}
+
+void PublishQueue::clear()
+{
+    head = 0;
+    count = 0;
+}
+
+int PublishQueue::length()
+{
+    return count;
+}
+
+unsigned long PublishQueue::getDroppedCount()
+{
+    return droppedCount;
+}
+
+void PublishQueue::refill(unsigned long now)
+{
+    if (tokens >= tokenCapacity)
+    {
+        // A full bucket doesn't bank the time it's been full.
+        refilledAt = now;
+        return;
+    }
+
+    unsigned long elapsed = now - refilledAt;
+    unsigned long due = elapsed / tokenInterval;
+    if (due == 0)
+    {
+        return;
+    }
+
+    tokens = due >= (unsigned long)(tokenCapacity - tokens) ?
+        tokenCapacity : tokens + due;
+    refilledAt += due * tokenInterval;
+}
@@ -0,0 +1,75 @@
+#ifndef PUBLISH_QUEUE_H_
+#define PUBLISH_QUEUE_H_
+
+#include "application.h"
+
+// The number of events that can wait to be published.
+#define PublishQueueCapacity 8
+
+// Large enough for an event name, including the terminator.
+#define PublishQueueNameMaxLength 32
+
+// The cloud only accepts 63 bytes of event data.
+#define PublishQueueDataMaxLength 64
+
+// An event waiting to be published.
+struct PublishQueueEvent
+{
+    char name[PublishQueueNameMaxLength];
+    char data[PublishQueueDataMaxLength];
+};
+
+// Queues events for Spark.publish so they're sent out at the rate the
+// cloud accepts, rather than dropped or blocking when they come in
+// bursts. A token bucket allows a burst of a few events and then one per
+// interval, and an event that comes in while one with the same name is
+// still waiting is batched into it, its data appended after a comma. All
+// times are in milliseconds.
+class PublishQueue
+{
+    public:
+        // ctor, the bucket starts out full.
+        PublishQueue(uint8_t tokenCapacity, unsigned long tokenInterval,
+            unsigned long now);
+
+        // Queues an event. Returns false if it couldn't be queued, the
+        // queue is full or the name or data are too long.
+        bool enqueue(const char* name, const char* data);
+
+        // Publishes the waiting events that there are tokens for. To be
+        // called in the Spark loop.
+        void poll(unsigned long now);
+
+        // Drops the waiting events.
+        void clear();
+
+        // The number of events waiting to be published.
+        int length();
+
+        // The number of events dropped since start up because the queue
+        // was full.
+        unsigned long getDroppedCount();
+    private:
+        PublishQueueEvent events[PublishQueueCapacity];
+
+        // Index of the oldest waiting event.
+        int head;
+
+        int count;
+
+        unsigned long droppedCount;
+
+        uint8_t tokenCapacity;
+
+        unsigned long tokenInterval;
+
+        uint8_t tokens;
+
+        // When the last token was added to the bucket.
+        unsigned long refilledAt;
+
+        // Adds the tokens that have come due since the last refill.
+        void refill(unsigned long now);
+};
+
+#endif // PUBLISH_QUEUE_H_
@@ -0,0 +1,71 @@
+#include "ScheduleCalendar.h"
+
+// The first bit of each month, laid out as a leap year.
+static const uint16_t monthStartBits[12] =
+{
+    0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335
+};
+
+static const uint8_t monthDays[12] =
+{
+    31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+};
+
+ScheduleCalendar::ScheduleCalendar()
+{
+    clear();
+}
+
+void ScheduleCalendar::add(int month, int day)
+{
+    int bit = GetBit(month, day);
+    if (bit != -1)
+    {
+        bits[bit >> 3] |= 1 << (bit & 7);
+    }
+}
+
+void ScheduleCalendar::remove(int month, int day)
+{
+    int bit = GetBit(month, day);
+    if (bit != -1)
+    {
+        bits[bit >> 3] &= ~(1 << (bit & 7));
+    }
+}
+
+void ScheduleCalendar::clear()
+{
+    memset(bits, 0, sizeof(bits));
+}
+
+bool ScheduleCalendar::contains(long day)
+{
+    int bit = GetBit(day);
+    return (bits[bit >> 3] >> (bit & 7)) & 1;
+}
+
+int ScheduleCalendar::GetBit(int month, int day)
+{
+    if (month < 1 || month > 12 || day < 1 || day > monthDays[month - 1])
+    {
+        return -1;
+    }
+
+    return monthStartBits[month - 1] + day - 1;
+}
+
+int ScheduleCalendar::GetBit(long day)
+{
+    // Days since 1970-01-01 to the day of a year starting in March, see
+    // http://howardhinnant.github.io/date_algorithms.html#civil_from_days
+    long z = day + 719468;
+    long era = (z >= 0 ? z : z - 146096) / 146097;
+    long dayOfEra = z - era * 146097;
+    long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    long dayOfMarchYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+
+    // Feb 29 is the last day of a March year, so Jan and Feb are always
+    // the first 60 bits and Mar 1 is always bit 60.
+    return dayOfMarchYear >= 306 ? dayOfMarchYear - 306 : dayOfMarchYear + 60;
+}
@@ -0,0 +1,40 @@
+#ifndef SCHEDULE_CALENDAR_H_
+#define SCHEDULE_CALENDAR_H_
+
+#include "application.h"
+
+// One bit for every day of a leap year, Feb 29 included.
+#define ScheduleCalendarDays 366
+
+// A set of yearly dates, e.g. holidays, stored as a 366-bit bitmap. Each
+// date has the same bit every year, so Mar 1 is the same bit in leap years
+// and in common years. One calendar can be shared by any number of tasks.
+class ScheduleCalendar
+{
+    public:
+        // ctor
+        ScheduleCalendar();
+
+        // Adds a date, the month and the day both start at 1.
+        void add(int month, int day);
+
+        // Removes a date.
+        void remove(int month, int day);
+
+        // Removes all of the dates.
+        void clear();
+
+        // True if the date of a day, in days since the unix epoch, is in
+        // the calendar.
+        bool contains(long day);
+    private:
+        uint8_t bits[(ScheduleCalendarDays + 7) / 8];
+
+        // The bit of a month and day, or -1 if it isn't a valid date.
+        static int GetBit(int month, int day);
+
+        // The bit of a day in days since the unix epoch.
+        static int GetBit(long day);
+};
+
+#endif // SCHEDULE_CALENDAR_H_
@@ -0,0 +1,132 @@
+#include "ScheduleIntervalIndex.h"
+
+ScheduleIntervalIndex::ScheduleIntervalIndex(int capacity)
+{
+    this->capacity = 0;
+    intervals = NULL;
+    intervalsLength = 0;
+    reserve(capacity);
+}
+
+ScheduleIntervalIndex::~ScheduleIntervalIndex()
+{
+    delete[] intervals;
+}
+
+void ScheduleIntervalIndex::reserve(int capacity)
+{
+    if (capacity <= this->capacity)
+    {
+        return;
+    }
+
+    ScheduleInterval* resized = new ScheduleInterval[capacity];
+    if (intervals != NULL)
+    {
+        memcpy(resized, intervals, intervalsLength * sizeof(ScheduleInterval));
+        delete[] intervals;
+    }
+
+    intervals = resized;
+    this->capacity = capacity;
+}
+
+void ScheduleIntervalIndex::clear()
+{
+    intervalsLength = 0;
+}
+
+void ScheduleIntervalIndex::add(int start, int end)
+{
+    if (start == end)
+    {
+        return;
+    }
+
+    if (end < start)
+    {
+        // Split intervals that wrap around midnight.
+        append(start, MinutesPerDay);
+        append(0, end);
+    }
+    else
+    {
+        append(start, end);
+    }
+}
+
+void ScheduleIntervalIndex::append(int start, int end)
+{
+    if (intervalsLength == capacity)
+    {
+        reserve(capacity * 2 + 2);
+    }
+
+    intervals[intervalsLength].start = start;
+    intervals[intervalsLength].end = end;
+    intervalsLength++;
+}
+
+void ScheduleIntervalIndex::build()
+{
+    // Insertion sort by start, there are only a few intervals per task.
+    for (int i = 1; i < intervalsLength; i++)
+    {
+        ScheduleInterval interval = intervals[i];
+        int j = i;
+        while (j > 0 && intervals[j - 1].start > interval.start)
+        {
+            intervals[j] = intervals[j - 1];
+            j--;
+        }
+        intervals[j] = interval;
+    }
+
+    // Merge the overlapping and adjacent intervals.
+    int merged = 0;
+    for (int i = 0; i < intervalsLength; i++)
+    {
+        if (merged > 0 && intervals[i].start <= intervals[merged - 1].end)
+        {
+            if (intervals[i].end > intervals[merged - 1].end)
+            {
+                intervals[merged - 1].end = intervals[i].end;
+            }
+        }
+        else
+        {
+            intervals[merged++] = intervals[i];
+        }
+    }
+
+    intervalsLength = merged;
+}
+
+bool ScheduleIntervalIndex::contains(int minuteOfDay)
+{
+    // Find the last interval that starts at or before the minute.
+    int low = 0;
+    int high = intervalsLength - 1;
+    int found = -1;
+
+    while (low <= high)
+    {
+        int middle = (low + high) / 2;
+        if (intervals[middle].start <= minuteOfDay)
+        {
+            found = middle;
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+
+    return found != -1 && minuteOfDay < intervals[found].end;
+}
+
+int ScheduleIntervalIndex::length()
+{
+    return intervalsLength;
+}
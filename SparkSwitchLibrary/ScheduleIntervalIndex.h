@@ -0,0 +1,54 @@
+#ifndef SCHEDULE_INTERVAL_INDEX_H_
+#define SCHEDULE_INTERVAL_INDEX_H_
+
+#include "application.h"
+
+#define MinutesPerDay 1440
+
+// A half-open range of minutes since midnight, [start, end).
+struct ScheduleInterval
+{
+    uint16_t start;
+    uint16_t end;
+};
+
+// Answers "is any task active at this minute?" with a binary search over
+// the merged, disjoint intervals of every task.
+class ScheduleIntervalIndex
+{
+    public:
+        // ctor
+        ScheduleIntervalIndex(int capacity);
+
+        ~ScheduleIntervalIndex();
+
+        // Makes room for at least the given number of intervals.
+        void reserve(int capacity);
+
+        // Removes all of the intervals.
+        void clear();
+
+        // Adds the interval between two minutes of the day. If the end is
+        // before the start, the interval wraps around midnight. Call build()
+        // once all of the intervals have been added.
+        void add(int start, int end);
+
+        // Sorts and merges the intervals that have been added.
+        void build();
+
+        // True if the minute of the day falls inside one of the intervals.
+        bool contains(int minuteOfDay);
+
+        // The number of disjoint intervals.
+        int length();
+    private:
+        ScheduleInterval* intervals;
+
+        int capacity;
+
+        int intervalsLength;
+
+        void append(int start, int end);
+};
+
+#endif // SCHEDULE_INTERVAL_INDEX_H_
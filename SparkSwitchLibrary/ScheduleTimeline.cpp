@@ -0,0 +1,97 @@
+#include "ScheduleTimeline.h"
+
+ScheduleTimeline::ScheduleTimeline(int capacity)
+{
+    this->capacity = 0;
+    events = NULL;
+    clear();
+    reserve(capacity);
+}
+
+ScheduleTimeline::~ScheduleTimeline()
+{
+    delete[] events;
+}
+
+void ScheduleTimeline::reserve(int capacity)
+{
+    if (capacity <= this->capacity)
+    {
+        return;
+    }
+
+    ScheduleTimelineEvent* resized = new ScheduleTimelineEvent[capacity];
+    if (events != NULL)
+    {
+        memcpy(resized, events + head,
+            (tail - head) * sizeof(ScheduleTimelineEvent));
+        delete[] events;
+    }
+
+    events = resized;
+    tail -= head;
+    head = 0;
+    this->capacity = capacity;
+}
+
+void ScheduleTimeline::clear()
+{
+    head = 0;
+    tail = 0;
+}
+
+bool ScheduleTimeline::add(time_t time, int taskIndex, uint8_t event)
+{
+    // Reclaim the space of events that have already been popped.
+    if (tail == capacity && head > 0)
+    {
+        memmove(events, events + head,
+            (tail - head) * sizeof(ScheduleTimelineEvent));
+        tail -= head;
+        head = 0;
+    }
+
+    if (tail == capacity)
+    {
+        return false;
+    }
+
+    // Insertion sort, the timeline is only built a few times a day. Events
+    // with the same time keep the order they were added in.
+    int i = tail;
+    while (i > head && events[i - 1].time > time)
+    {
+        events[i] = events[i - 1];
+        i--;
+    }
+
+    events[i].time = time;
+    events[i].taskIndex = taskIndex;
+    events[i].event = event;
+    tail++;
+
+    return true;
+}
+
+bool ScheduleTimeline::isEmpty()
+{
+    return head == tail;
+}
+
+ScheduleTimelineEvent* ScheduleTimeline::peek()
+{
+    return isEmpty() ? NULL : &events[head];
+}
+
+void ScheduleTimeline::pop()
+{
+    if (!isEmpty())
+    {
+        head++;
+    }
+}
+
+int ScheduleTimeline::length()
+{
+    return tail - head;
+}
@@ -0,0 +1,62 @@
+#ifndef SCHEDULE_TIMELINE_H_
+#define SCHEDULE_TIMELINE_H_
+
+#include "application.h"
+
+// A single transition on the timeline.
+struct ScheduleTimelineEvent
+{
+    // When the transition occurs as a unix timestamp.
+    time_t time;
+
+    // Index of the task in the scheduler's task list.
+    int taskIndex;
+
+    // The SwitchSchedulerEvent that should be fired.
+    uint8_t event;
+};
+
+// A queue of upcoming scheduler transitions kept sorted by time, so the
+// next transition is always at the head.
+class ScheduleTimeline
+{
+    public:
+        // ctor
+        ScheduleTimeline(int capacity);
+
+        ~ScheduleTimeline();
+
+        // Makes room for at least the given number of events.
+        void reserve(int capacity);
+
+        // Removes all of the events from the timeline.
+        void clear();
+
+        // Inserts an event in time order. Returns false if the timeline
+        // is full.
+        bool add(time_t time, int taskIndex, uint8_t event);
+
+        // True if there are no more events on the timeline.
+        bool isEmpty();
+
+        // Gets the next event on the timeline, or NULL if it's empty.
+        ScheduleTimelineEvent* peek();
+
+        // Removes the next event from the timeline.
+        void pop();
+
+        // The number of events left on the timeline.
+        int length();
+    private:
+        ScheduleTimelineEvent* events;
+
+        int capacity;
+
+        // Index of the next event.
+        int head;
+
+        // Index one past the last event.
+        int tail;
+};
+
+#endif // SCHEDULE_TIMELINE_H_
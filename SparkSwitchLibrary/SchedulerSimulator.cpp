@@ -0,0 +1,144 @@
+#include "SchedulerSimulator.h"
+
+SchedulerSimulator* SchedulerSimulator::running = NULL;
+
+SchedulerSimulator::SchedulerSimulator(SwitchSchedulerConfiguration* config,
+    SparkTime* rtc, uint32_t start)
+{
+    this->rtc = rtc;
+    clock = new VirtualClock(start);
+
+    // Keep the simulation off the network and out of the EEPROM.
+    SwitchSchedulerConfiguration simulated = *config;
+    simulated.astronomyApiUrl = "";
+    simulated.astronomyCacheAddress = -1;
+    scheduler = new SwitchScheduler(&simulated, rtc, clock);
+
+    transitions = 0;
+    dayTransitions = 0;
+    lastEvent = -1;
+    totalMicros = 0;
+    maxDayMicros = 0;
+}
+
+SchedulerSimulator::~SchedulerSimulator()
+{
+    // The scheduler still uses the clock, so it goes first.
+    delete scheduler;
+    delete clock;
+}
+
+void SchedulerSimulator::addTask(SwitchSchedulerTask* task)
+{
+    SwitchSchedulerTask simulated = *task;
+    simulated.callback = &SchedulerSimulator::OnTransition;
+    scheduler->addSchedulerTask(&simulated);
+}
+
+void SchedulerSimulator::run(int days, unsigned long step, Print* output)
+{
+    running = this;
+
+    for (int day = 0; day < days; day++)
+    {
+        uint32_t dayStart = clock->now();
+        time_t sunriseTime = 0;
+        time_t sunsetTime = 0;
+        dayTransitions = 0;
+
+        unsigned long started = micros();
+        for (unsigned long elapsed = 0; elapsed < 86400UL; elapsed += step)
+        {
+            scheduler->tock();
+
+            // The loop checks this every time for the state variable.
+            scheduler->shouldBeToggled();
+
+            // Once DST starts the simulated days start an hour into the
+            // local day, so report the astronomy data from the middle.
+            if (elapsed < 43200UL && elapsed + step >= 43200UL)
+            {
+                sunriseTime = scheduler->getSunriseTime();
+                sunsetTime = scheduler->getSunsetTime();
+            }
+
+            clock->advance(step * 1000UL);
+        }
+        unsigned long dayMicros = micros() - started;
+
+        transitions += dayTransitions;
+        totalMicros += dayMicros;
+        if (dayMicros > maxDayMicros)
+        {
+            maxDayMicros = dayMicros;
+        }
+
+        // e.g. "2014-03-09 dst=1 sunrise=07:46 sunset=19:40 transitions=2 us=5120"
+        output->print(rtc->ISODateString(dayStart).substring(0, 10));
+        output->print(" dst=");
+        output->print(rtc->isUSDST(dayStart) ? 1 : 0);
+        output->print(" sunrise=");
+        printTime(output, sunriseTime);
+        output->print(" sunset=");
+        printTime(output, sunsetTime);
+        output->print(" transitions=");
+        output->print(dayTransitions);
+        output->print(" us=");
+        output->println(dayMicros);
+    }
+
+    output->print("days=");
+    output->print(days);
+    output->print(" transitions=");
+    output->print(transitions);
+    output->print(" us=");
+    output->print(totalMicros);
+    output->print(" max_day_us=");
+    output->println(maxDayMicros);
+
+    // How late the transitions fired with this step.
+    char latency[FireLatencyMaxLength];
+    scheduler->getFireLatencyStats()->printTo(latency, sizeof(latency));
+    output->print("latency=");
+    output->println(latency);
+
+    running = NULL;
+}
+
+long SchedulerSimulator::getTransitions()
+{
+    return transitions;
+}
+
+unsigned long SchedulerSimulator::getTotalMicros()
+{
+    return totalMicros;
+}
+
+unsigned long SchedulerSimulator::getMaxDayMicros()
+{
+    return maxDayMicros;
+}
+
+void SchedulerSimulator::OnTransition(int event)
+{
+    if (running != NULL && event != running->lastEvent)
+    {
+        running->lastEvent = event;
+        running->dayTransitions++;
+    }
+}
+
+void SchedulerSimulator::printTime(Print* output, time_t time)
+{
+    if (time == 0)
+    {
+        output->print("--:--");
+        return;
+    }
+
+    char buffer[8];
+    uint32_t t = time + SPARKTIMEEPOCHSTART;
+    snprintf(buffer, sizeof(buffer), "%02d:%02d", rtc->hour(t), rtc->minute(t));
+    output->print(buffer);
+}
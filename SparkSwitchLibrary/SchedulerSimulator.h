@@ -0,0 +1,65 @@
+#ifndef SCHEDULER_SIMULATOR_H_
+#define SCHEDULER_SIMULATOR_H_
+
+#include "application.h"
+#include "SparkTime.h"
+#include "SwitchClock.h"
+#include "SwitchScheduler.h"
+
+// Replays days of scheduling against a virtual clock as fast as the CPU
+// allows, to benchmark and regression test the scheduler. The simulated
+// scheduler never touches the network or the EEPROM, the sunrise and
+// sunset are calculated on the device.
+class SchedulerSimulator
+{
+    public:
+        // ctor, the simulation starts at the given seconds since 1900.
+        SchedulerSimulator(SwitchSchedulerConfiguration*, SparkTime*,
+            uint32_t start);
+
+        ~SchedulerSimulator();
+
+        // Adds a task to the simulated scheduler. Its callback is replaced
+        // with one that counts the transitions.
+        void addTask(SwitchSchedulerTask*);
+
+        // Runs the scheduler for a number of days, ticking it every step
+        // in seconds, and prints a line per day with the transitions and
+        // the time spent evaluating the schedule to the output.
+        void run(int days, unsigned long step, Print* output);
+
+        // Totals over every day simulated so far.
+        long getTransitions();
+        unsigned long getTotalMicros();
+        unsigned long getMaxDayMicros();
+    private:
+        SparkTime* rtc;
+
+        VirtualClock* clock;
+
+        SwitchScheduler* scheduler;
+
+        long transitions;
+
+        long dayTransitions;
+
+        // The event of the last transition, or -1. The scheduler also calls
+        // back with the current state when it re-evaluates the switch,
+        // which only counts if the state has changed.
+        int lastEvent;
+
+        unsigned long totalMicros;
+
+        unsigned long maxDayMicros;
+
+        // Task callbacks are plain functions, so they find the simulator
+        // that's running through this.
+        static SchedulerSimulator* running;
+
+        static void OnTransition(int event);
+
+        // Prints a unix timestamp as the local hh:mm.
+        void printTime(Print* output, time_t time);
+};
+
+#endif // SCHEDULER_SIMULATOR_H_
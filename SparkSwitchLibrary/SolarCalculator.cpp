@@ -0,0 +1,92 @@
+#include <math.h>
+#include "SolarCalculator.h"
+
+#define SOLAR_PI 3.14159265358979323846
+#define SOLAR_RADIANS(degrees) ((degrees) * SOLAR_PI / 180.0)
+#define SOLAR_DEGREES(radians) ((radians) * 180.0 / SOLAR_PI)
+
+bool SolarCalculator::Calculate(long day, float latitude, float longitude,
+    SolarTwilight::SolarTwilightEnum twilight, int zoneOffset,
+    int* sunriseMinute, int* sunsetMinute)
+{
+    int year, dayOfYear;
+    GetDayOfYear(day, &year, &dayOfYear);
+
+    // Fractional year at local noon, in radians.
+    int daysInYear = (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)) ? 366 : 365;
+    double gamma = 2.0 * SOLAR_PI / daysInYear * dayOfYear;
+
+    // Equation of time in minutes.
+    double equationOfTime = 229.18 * (0.000075
+        + 0.001868 * cos(gamma) - 0.032077 * sin(gamma)
+        - 0.014615 * cos(2 * gamma) - 0.040849 * sin(2 * gamma));
+
+    // Solar declination in radians.
+    double declination = 0.006918
+        - 0.399912 * cos(gamma) + 0.070257 * sin(gamma)
+        - 0.006758 * cos(2 * gamma) + 0.000907 * sin(2 * gamma)
+        - 0.002697 * cos(3 * gamma) + 0.00148 * sin(3 * gamma);
+
+    double latitudeRadians = SOLAR_RADIANS(latitude);
+    double cosHourAngle = cos(SOLAR_RADIANS(GetZenith(twilight))) /
+        (cos(latitudeRadians) * cos(declination)) -
+        tan(latitudeRadians) * tan(declination);
+
+    // The sun stays above or below the horizon all day.
+    if (cosHourAngle > 1.0 || cosHourAngle < -1.0)
+    {
+        return false;
+    }
+
+    double hourAngle = SOLAR_DEGREES(acos(cosHourAngle));
+
+    // Minutes since UTC midnight, each degree of longitude is 4 minutes.
+    double sunrise = 720.0 - 4.0 * (longitude + hourAngle) - equationOfTime;
+    double sunset = 720.0 - 4.0 * (longitude - hourAngle) - equationOfTime;
+
+    *sunriseMinute = ((int)floor(sunrise + zoneOffset + 0.5) + 1440) % 1440;
+    *sunsetMinute = ((int)floor(sunset + zoneOffset + 0.5) + 1440) % 1440;
+
+    return true;
+}
+
+double SolarCalculator::GetZenith(SolarTwilight::SolarTwilightEnum twilight)
+{
+    switch (twilight)
+    {
+        case SolarTwilight::Civil:
+            return 96.0;
+        case SolarTwilight::Nautical:
+            return 102.0;
+        case SolarTwilight::Astronomical:
+            return 108.0;
+        default:
+            // Accounts for refraction and the size of the sun's disc.
+            return 90.833;
+    }
+}
+
+void SolarCalculator::GetDayOfYear(long day, int* year, int* dayOfYear)
+{
+    // Days since 1970-01-01 to a civil date, see
+    // http://howardhinnant.github.io/date_algorithms.html#civil_from_days
+    long z = day + 719468;
+    long era = (z >= 0 ? z : z - 146096) / 146097;
+    long dayOfEra = z - era * 146097;
+    long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    long dayOfMarchYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+
+    // The algorithm's years start in March, shift back to January.
+    int y = yearOfEra + era * 400;
+    bool isBeforeMarch = dayOfMarchYear >= 306;
+    if (isBeforeMarch)
+    {
+        y++;
+    }
+
+    bool isLeapYear = (y % 4 == 0 && (y % 100 != 0 || y % 400 == 0));
+    *year = y;
+    *dayOfYear = isBeforeMarch ?
+        dayOfMarchYear - 306 :
+        dayOfMarchYear + 59 + (isLeapYear ? 1 : 0);
+}
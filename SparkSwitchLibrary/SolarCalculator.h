@@ -0,0 +1,43 @@
+#ifndef SOLAR_CALCULATOR_H_
+#define SOLAR_CALCULATOR_H_
+
+#include "application.h"
+
+// How far below the horizon the sun has to be for it to count as risen or
+// set.
+struct SolarTwilight
+{
+    enum SolarTwilightEnum
+    {
+        // The sun's upper limb touches the horizon.
+        Official,
+        Civil,
+        Nautical,
+        Astronomical
+    };
+};
+
+// Calculates sunrise and sunset times on the device using the NOAA solar
+// position equations, accurate to within a couple of minutes.
+class SolarCalculator
+{
+    public:
+        // Calculates the sunrise and sunset of a day as local minutes since
+        // midnight. The day is the number of days since the unix epoch,
+        // latitude is positive north, longitude is positive east and the
+        // zone offset is in minutes. Returns false if the sun doesn't rise
+        // or set that day.
+        static bool Calculate(long day, float latitude, float longitude,
+            SolarTwilight::SolarTwilightEnum twilight, int zoneOffset,
+            int* sunriseMinute, int* sunsetMinute);
+
+    private:
+        // The solar zenith angle in degrees for the twilight kind.
+        static double GetZenith(SolarTwilight::SolarTwilightEnum twilight);
+
+        // Converts days since the unix epoch into the year and the day of
+        // the year, starting at 0.
+        static void GetDayOfYear(long day, int* year, int* dayOfYear);
+};
+
+#endif // SOLAR_CALCULATOR_H_
@@ -95,3 +95,22 @@ String Sparky::ISODateString(SparkTime* rtc, time_t timestamp)
     }
     return ISOString;
 }
+
+int Sparky::FormatISODate(SparkTime* rtc, time_t timestamp, char* buffer,
+    size_t bufferSize)
+{
+    uint32_t t = timestamp + SPARKTIMEEPOCHSTART;
+
+    // SparkTime's calendar starts in 2014, earlier times, e.g. a sunset
+    // that hasn't been calculated yet, are printed as the unix epoch.
+    int32_t offset = t < SPARKTIMEBASESTART ? 0 : rtc->getZoneOffset(t);
+    if (t < SPARKTIMEBASESTART || t + offset * 3600L < SPARKTIMEBASESTART)
+    {
+        return snprintf(buffer, bufferSize, "1970-01-01T00:00:00+0000");
+    }
+
+    return snprintf(buffer, bufferSize, "%04lu-%02u-%02uT%02u:%02u:%02u%c%02ld00",
+        (unsigned long)rtc->year(t), rtc->month(t), rtc->day(t),
+        rtc->hour(t), rtc->minute(t), rtc->second(t),
+        offset < 0 ? '-' : '+', (long)(offset < 0 ? -offset : offset));
+}
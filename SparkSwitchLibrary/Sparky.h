@@ -3,6 +3,9 @@
 
 #define StringVariableMaxLength 622
 
+// Large enough for an ISO 8601 date, e.g. "2014-01-01T19:00:00-0500".
+#define ISODateMaxLength 25
+
 #include "application.h"
 #include "SparkTime.h"
 
@@ -33,6 +36,13 @@ class Sparky
         static void ParseTimestamp(time_t timestamp, int* hour, int* minute);
 
         static String ISODateString(SparkTime* rtc, time_t timestamp);
+
+        // Prints a unix timestamp as a local ISO 8601 date, e.g.
+        // "2014-01-01T19:00:00-0500", without allocating. Returns the
+        // length of the date, which is truncated if the buffer is too
+        // small. Times before 2014 are printed as the unix epoch.
+        static int FormatISODate(SparkTime* rtc, time_t timestamp,
+            char* buffer, size_t bufferSize);
 };
 
 #endif // SPARKY_H_
@@ -0,0 +1,94 @@
+#include "SwitchActuator.h"
+
+SwitchActuator::SwitchActuator(unsigned long coalesceWindow,
+    unsigned long minimumOnTime, unsigned long minimumOffTime)
+{
+    this->coalesceWindow = coalesceWindow;
+    this->minimumOnTime = minimumOnTime;
+    this->minimumOffTime = minimumOffTime;
+
+    reset(false, 0);
+}
+
+void SwitchActuator::setCoalesceWindow(unsigned long window)
+{
+    coalesceWindow = window;
+}
+
+void SwitchActuator::setMinimumOnTime(unsigned long time)
+{
+    minimumOnTime = time;
+}
+
+void SwitchActuator::setMinimumOffTime(unsigned long time)
+{
+    minimumOffTime = time;
+}
+
+void SwitchActuator::reset(bool state, unsigned long now)
+{
+    this->state = state;
+    pendingState = state;
+    hasPendingState = false;
+    requestedAt = now;
+    changedAt = now;
+}
+
+void SwitchActuator::request(bool state, unsigned long now)
+{
+    // The window starts with the first request of a burst.
+    if (!hasPendingState)
+    {
+        requestedAt = now;
+    }
+
+    // A burst that ends up where it started doesn't need a write.
+    pendingState = state;
+    hasPendingState = state != this->state;
+}
+
+bool SwitchActuator::force(bool state, unsigned long now)
+{
+    hasPendingState = false;
+
+    if (state == this->state)
+    {
+        return false;
+    }
+
+    this->state = state;
+    pendingState = state;
+    changedAt = now;
+    return true;
+}
+
+bool SwitchActuator::poll(unsigned long now, bool* state)
+{
+    if (!hasPendingState || now - requestedAt < coalesceWindow)
+    {
+        return false;
+    }
+
+    unsigned long dwell = this->state ? minimumOnTime : minimumOffTime;
+    if (now - changedAt < dwell)
+    {
+        return false;
+    }
+
+    this->state = pendingState;
+    hasPendingState = false;
+    changedAt = now;
+
+    *state = this->state;
+    return true;
+}
+
+bool SwitchActuator::getState()
+{
+    return state;
+}
+
+bool SwitchActuator::isPending()
+{
+    return hasPendingState;
+}
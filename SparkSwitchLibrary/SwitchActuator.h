@@ -0,0 +1,65 @@
+#ifndef SWITCH_ACTUATOR_H_
+#define SWITCH_ACTUATOR_H_
+
+#include "application.h"
+
+// Sits between the scheduler and the outlet switch and decides when a
+// requested state actually gets written. Requests that don't change the
+// state are dropped, bursts of requests are merged into one write once
+// they settle, and the switch stays on or off for a minimum time before
+// it changes again. All times are in milliseconds.
+class SwitchActuator
+{
+    public:
+        // ctor
+        SwitchActuator(unsigned long coalesceWindow,
+            unsigned long minimumOnTime, unsigned long minimumOffTime);
+
+        // How long to wait after the first of a burst of requests before
+        // writing the last one.
+        void setCoalesceWindow(unsigned long window);
+
+        // How long the switch has to stay on or off before it can change.
+        void setMinimumOnTime(unsigned long time);
+        void setMinimumOffTime(unsigned long time);
+
+        // Sets the state the switch was written with, e.g. on start up.
+        void reset(bool state, unsigned long now);
+
+        // Requests a state change, it's written once poll() says so.
+        void request(bool state, unsigned long now);
+
+        // Changes the state right away, bypassing the window and the dwell
+        // times, and drops any pending request. Returns false if the
+        // switch is already in that state.
+        bool force(bool state, unsigned long now);
+
+        // Returns true and the state to write if a pending request is due.
+        bool poll(unsigned long now, bool* state);
+
+        // The state the switch was last written with.
+        bool getState();
+
+        // True if there's a request waiting to be written.
+        bool isPending();
+    private:
+        unsigned long coalesceWindow;
+
+        unsigned long minimumOnTime;
+
+        unsigned long minimumOffTime;
+
+        bool state;
+
+        bool pendingState;
+
+        bool hasPendingState;
+
+        // When the first request of the pending burst came in.
+        unsigned long requestedAt;
+
+        // When the state was last written.
+        unsigned long changedAt;
+};
+
+#endif // SWITCH_ACTUATOR_H_
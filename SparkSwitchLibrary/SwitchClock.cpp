@@ -0,0 +1,56 @@
+#include "SwitchClock.h"
+
+uint32_t SwitchClock::nowEpoch()
+{
+    return now() - SPARKTIMEEPOCHSTART;
+}
+
+SparkTimeClock::SparkTimeClock(SparkTime* rtc)
+{
+    this->rtc = rtc;
+}
+
+unsigned long SparkTimeClock::millis()
+{
+    return ::millis();
+}
+
+uint32_t SparkTimeClock::now()
+{
+    return rtc->now();
+}
+
+void SparkTimeClock::sync()
+{
+    Spark.syncTime();
+}
+
+VirtualClock::VirtualClock(uint32_t now)
+{
+    milliseconds = 0;
+    seconds = now;
+    pendingMilliseconds = 0;
+}
+
+unsigned long VirtualClock::millis()
+{
+    return milliseconds;
+}
+
+uint32_t VirtualClock::now()
+{
+    return seconds;
+}
+
+void VirtualClock::sync()
+{
+}
+
+void VirtualClock::advance(unsigned long milliseconds)
+{
+    // millis() wraps like the real one, the seconds keep counting.
+    this->milliseconds += milliseconds;
+    pendingMilliseconds += milliseconds;
+    seconds += pendingMilliseconds / 1000;
+    pendingMilliseconds %= 1000;
+}
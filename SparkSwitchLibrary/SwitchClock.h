@@ -0,0 +1,68 @@
+#ifndef SWITCH_CLOCK_H_
+#define SWITCH_CLOCK_H_
+
+#include "application.h"
+#include "SparkTime.h"
+
+// Where the scheduler gets the time from, so it can be run against a
+// simulated clock instead of the real one.
+class SwitchClock
+{
+    public:
+        virtual ~SwitchClock() {}
+
+        // Milliseconds since start up, like millis().
+        virtual unsigned long millis() = 0;
+
+        // Seconds since 1900, like SparkTime::now().
+        virtual uint32_t now() = 0;
+
+        // Seconds since the unix epoch, like SparkTime::nowEpoch().
+        uint32_t nowEpoch();
+
+        // Syncs the clock with the cloud.
+        virtual void sync() = 0;
+};
+
+// The device's clock.
+class SparkTimeClock : public SwitchClock
+{
+    public:
+        // ctor
+        SparkTimeClock(SparkTime* rtc);
+
+        unsigned long millis();
+
+        uint32_t now();
+
+        void sync();
+    private:
+        SparkTime* rtc;
+};
+
+// A clock that only moves when it's told to, as fast as the CPU allows.
+class VirtualClock : public SwitchClock
+{
+    public:
+        // ctor, starts at the given seconds since 1900.
+        VirtualClock(uint32_t now);
+
+        unsigned long millis();
+
+        uint32_t now();
+
+        // Does nothing, there's nothing to sync with.
+        void sync();
+
+        // Moves the clock forward.
+        void advance(unsigned long milliseconds);
+    private:
+        unsigned long milliseconds;
+
+        uint32_t seconds;
+
+        // The milliseconds that don't make up a whole second yet.
+        unsigned long pendingMilliseconds;
+};
+
+#endif // SWITCH_CLOCK_H_
@@ -1,39 +1,227 @@
 #include <math.h>
 #include "SparkDebug.h"
 #include "Sparky.h"
+#include "PerfectHash.h"
 #include "SwitchScheduler.h"
-#include "JsonParser.h"
-#include "arraylist.h"
-#include "Uri.h"
-#include "rest_client.h"
 
-SwitchSchedulerTask::SwitchSchedulerTask(String start, String end, void (*pCallback)(int))
+// Parses an unsigned decimal number, returns the position after the last
+// digit or NULL if there are no digits.
+static const char* parseNumber(const char* data, int* value)
 {
-    startTime = start;
-    endTime = end;
+    const char* p = data;
+    *value = 0;
+
+    while (*p >= '0' && *p <= '9' && p - data < 4)
+    {
+        *value = *value * 10 + (*p - '0');
+        p++;
+    }
+
+    return p == data ? NULL : p;
+}
+
+bool SwitchSchedulerRule::isAstronomical() const
+{
+    return kind == Sunrise || kind == Sunset;
+}
+
+SwitchSchedulerRule SwitchSchedulerRule::compile(const char* timeString)
+{
+    SwitchSchedulerRule rule;
+    rule.kind = Invalid;
+    rule.minuteOfDay = 0;
+    rule.offset = 0;
+
+    if (timeString == NULL)
+    {
+        return rule;
+    }
+
+    const char* p = timeString;
+    int hour, minute;
+
+    if (strncmp(p, "sunrise", 7) == 0 || strncmp(p, "sunset", 6) == 0)
+    {
+        uint8_t kind = (p[3] == 'r') ? Sunrise : Sunset;
+        p += (kind == Sunrise) ? 7 : 6;
+
+        // Optional offset in minutes, e.g. "sunset+30".
+        if (*p == '+' || *p == '-')
+        {
+            int sign = (*p == '-') ? -1 : 1;
+            if ((p = parseNumber(p + 1, &minute)) == NULL || minute >= 24 * 60)
+            {
+                return rule;
+            }
+
+            rule.offset = sign * minute;
+        }
+
+        if (*p == 0)
+        {
+            rule.kind = kind;
+        }
+
+        return rule;
+    }
+
+    // Fixed time in the format h:mm
+    if ((p = parseNumber(p, &hour)) == NULL || *p != ':' ||
+        (p = parseNumber(p + 1, &minute)) == NULL || *p != 0 ||
+        hour > 23 || minute > 59)
+    {
+        return rule;
+    }
+
+    rule.kind = Fixed;
+    rule.minuteOfDay = hour * 60 + minute;
+
+    return rule;
+}
+
+void SwitchSchedulerRule::toString(char* buffer, size_t bufferSize) const
+{
+    switch (kind)
+    {
+        case Fixed:
+            snprintf(buffer, bufferSize, "%02d:%02d",
+                minuteOfDay / 60, minuteOfDay % 60);
+            break;
+        case Sunrise:
+        case Sunset:
+            snprintf(buffer, bufferSize, offset != 0 ? "%s%+d" : "%s",
+                kind == Sunrise ? "sunrise" : "sunset", offset);
+            break;
+        default:
+            snprintf(buffer, bufferSize, "invalid");
+            break;
+    }
+}
+
+SwitchSchedulerConfiguration::SwitchSchedulerConfiguration()
+{
+    isEnabled = false;
+    homeOnlyModeEnabled = false;
+    latitude = 0;
+    longitude = 0;
+    twilight = SolarTwilight::Official;
+    presenceTimeout = 0;
+    switchCoalesceWindow = 0;
+    switchMinimumOnTime = 0;
+    switchMinimumOffTime = 0;
+    astronomyCacheAddress = 0;
+}
+
+SwitchSchedulerTask::SwitchSchedulerTask()
+{
+    startTime = SwitchSchedulerRule::compile(NULL);
+    endTime = SwitchSchedulerRule::compile(NULL);
+    callback = NULL;
+    daysOfWeek = SwitchSchedulerDays::EveryDay;
+    exceptions = NULL;
+}
+
+SwitchSchedulerTask::SwitchSchedulerTask(const char* start, const char* end, void (*pCallback)(int),
+    uint8_t daysOfWeek, ScheduleCalendar* exceptions)
+{
+    startTime = SwitchSchedulerRule::compile(start);
+    endTime = SwitchSchedulerRule::compile(end);
     callback = pCallback;
+    this->daysOfWeek = daysOfWeek;
+    this->exceptions = exceptions;
 }
 
-SwitchScheduler::SwitchScheduler(SwitchSchedulerConfiguration* config, SparkTime* rtc)
+bool SwitchSchedulerTask::isScheduledOn(long day)
+{
+    // 1970-01-01 was a Thursday.
+    int dayOfWeek = (day + 4) % 7;
+    if (!(daysOfWeek & (1 << dayOfWeek)))
+    {
+        return false;
+    }
+
+    return exceptions == NULL || !exceptions->contains(day);
+}
+
+SwitchScheduler::SwitchScheduler(SwitchSchedulerConfiguration* config, SparkTime* rtc,
+    SwitchClock* clock)
 {
     configuration = new SwitchSchedulerConfiguration();
     this->rtc = rtc;
+    this->clock = clock != NULL ? clock : new SparkTimeClock(rtc);
+    ownsClock = clock == NULL;
 
     // time gets automagically sync'd on start up
-    lastTimeSync = millis();
-
-    tasks = new SwitchSchedulerTask*[10];
-    homeMobileIds = new arraylist<const char*>();
+    lastTimeSync = this->clock->millis();
+
+    tasksCapacity = 4;
+    tasks = new SwitchSchedulerTask[tasksCapacity];
+    resolvedTasks = new SwitchSchedulerResolvedTask[tasksCapacity];
+    tasksLength = 0;
+
+    timeline = new ScheduleTimeline(tasksCapacity * TimelineEventsPerTask);
+    activeIntervals = new ScheduleIntervalIndex(
+        tasksCapacity * IntervalsPerTask);
+    fireLatency = new FireLatencyStats();
+    isScheduleDirty = true;
+    scheduleExpiration = 0;
+    lastEvaluated = 0;
+    updateDepth = 0;
+    isToggledStatePending = false;
+    stateVersion = 0;
+    scheduleMidnight = 0;
+    scheduleDay = -1;
+    scheduleZoneOffset = 0;
+
+    _isUsingAstronomyData = false;
+    sunriseTime = 0;
+    sunsetTime = 0;
+    astronomyFetcher = new AstronomyDataFetcher();
+    astronomyDataDay = -1;
+    astronomyCalculatedDay = -1;
+    astronomyCache = new AstronomyCache(config->astronomyCacheAddress);
+    astronomyAttemptsDay = -1;
+    astronomyApiCheckMinute = -1;
+    nextLoopCheck = 0;
+    hasLoopChecked = false;
+
+    homeMobileIds = new PresenceSet();
+
+    // One second ticks, a rotation of the wheel covers about a minute.
+    presenceTimers = new TimerWheel(PresenceSetCapacity, 64, 1000,
+        this->clock->millis());
 
     initialize(config);
 }
 
+SwitchScheduler::~SwitchScheduler()
+{
+    delete configuration;
+    delete[] tasks;
+    delete[] resolvedTasks;
+    delete timeline;
+    delete activeIntervals;
+    delete fireLatency;
+    delete astronomyFetcher;
+    delete astronomyCache;
+    delete homeMobileIds;
+    delete presenceTimers;
+
+    if (ownsClock)
+    {
+        delete clock;
+    }
+}
+
 void SwitchScheduler::initialize(SwitchSchedulerConfiguration* config)
 {
     setAstronomyApiUrl(config->astronomyApiUrl);
     setAstronomyApiCheckTime(config->astronomyApiCheckTime);
     setIsEnabled(config->isEnabled);
     setHomeOnlyModeEnabled(config->homeOnlyModeEnabled);
+    setLocation(config->latitude, config->longitude);
+    setTwilight(static_cast<SolarTwilight::SolarTwilightEnum>(config->twilight));
+    setPresenceTimeout(config->presenceTimeout);
 }
 
 void SwitchScheduler::setAstronomyApiUrl(String apiUrl)
@@ -43,12 +231,21 @@ void SwitchScheduler::setAstronomyApiUrl(String apiUrl)
 
 void SwitchScheduler::setAstronomyApiCheckTime(String checkTime)
 {
+    SwitchSchedulerRule rule = SwitchSchedulerRule::compile(checkTime.c_str());
+    if (rule.kind != SwitchSchedulerRule::Fixed)
+    {
+        DEBUG_PRINT("Invalid astronomy API check time: " + checkTime + "\n");
+        return;
+    }
+
     configuration->astronomyApiCheckTime = checkTime;
+    astronomyApiCheckMinute = rule.minuteOfDay;
 }
 
 void SwitchScheduler::setIsEnabled(bool enabled)
 {
     configuration->isEnabled = enabled;
+    stateVersion++;
 }
 
 void SwitchScheduler::setHomeOnlyModeEnabled(bool enabled)
@@ -57,8 +254,77 @@ void SwitchScheduler::setHomeOnlyModeEnabled(bool enabled)
     checkToggledState();
 }
 
+void SwitchScheduler::setLocation(float latitude, float longitude)
+{
+    configuration->latitude = latitude;
+    configuration->longitude = longitude;
+    astronomyCache->load(getAstronomyCacheKey());
+    astronomyCalculatedDay = -1;
+}
+
+void SwitchScheduler::setTwilight(SolarTwilight::SolarTwilightEnum twilight)
+{
+    configuration->twilight = twilight;
+    astronomyCache->load(getAstronomyCacheKey());
+    astronomyCalculatedDay = -1;
+}
+
+void SwitchScheduler::setPresenceTimeout(unsigned long timeout)
+{
+    if (timeout > PresenceTimeoutMax)
+    {
+        DEBUG_PRINT("Presence timeout is too long, clamping it to a week.\n");
+        timeout = PresenceTimeoutMax;
+    }
+
+    configuration->presenceTimeout = timeout;
+
+    // Restart the timers of the mobile ids that are already home.
+    time_t now = clock->nowEpoch();
+    for (int handle = 0; handle < PresenceSetCapacity; handle++)
+    {
+        if (homeMobileIds->get(handle)[0] == '\0')
+        {
+            continue;
+        }
+
+        if (timeout == 0)
+        {
+            presenceTimers->cancel(handle);
+            continue;
+        }
+
+        time_t expiration = homeLastSeen[handle] + timeout;
+        presenceTimers->schedule(handle,
+            expiration > now ? (expiration - now) * 1000UL : 0,
+            clock->millis());
+    }
+}
+
+void SwitchScheduler::beginUpdate()
+{
+    updateDepth++;
+}
+
+void SwitchScheduler::endUpdate()
+{
+    if (updateDepth > 0 && --updateDepth == 0 && isToggledStatePending)
+    {
+        isToggledStatePending = false;
+        checkToggledState();
+    }
+}
+
 void SwitchScheduler::checkToggledState()
 {
+    stateVersion++;
+
+    if (updateDepth > 0)
+    {
+        isToggledStatePending = true;
+        return;
+    }
+
     if (tasksLength > 0)
     {
         SwitchSchedulerEvent::SwitchSchedulerEventEnum event =
@@ -66,7 +332,7 @@ void SwitchScheduler::checkToggledState()
                 SwitchSchedulerEvent::StartEvent :
                 SwitchSchedulerEvent::EndEvent;
 
-        tasks[0]->callback(static_cast<int>(event));
+        tasks[0].callback(static_cast<int>(event));
     }
 }
 
@@ -77,7 +343,7 @@ bool SwitchScheduler::isUsingAstronomyData()
 
 bool SwitchScheduler::isDst()
 {
-    return rtc->isUSDST(rtc->now());
+    return rtc->isUSDST(clock->now());
 }
 
 time_t SwitchScheduler::getSunriseTime()
@@ -95,32 +361,81 @@ int SwitchScheduler::getCurrentHomeCount()
     return homeMobileIds->length();
 }
 
-void SwitchScheduler::setHomeStatus(const char* mobileId)
+bool SwitchScheduler::setHomeStatus(const char* mobileId)
 {
-    if (homeMobileIds->indexOf(mobileId) == -1)
+    bool wasHome = homeMobileIds->find(mobileId) != -1;
+    int handle = homeMobileIds->add(mobileId);
+    if (handle == -1)
+    {
+        DEBUG_PRINT("Unable to track mobile id.\n");
+        return false;
+    }
+
+    homeLastSeen[handle] = clock->nowEpoch();
+
+    if (configuration->presenceTimeout > 0)
     {
-        // TODO: Save LastUpdated time as well
-        homeMobileIds->add(mobileId);
+        presenceTimers->schedule(handle,
+            configuration->presenceTimeout * 1000UL, clock->millis());
+    }
+
+    if (wasHome)
+    {
+        return false;
     }
 
     checkToggledState();
+    return true;
 }
 
-void SwitchScheduler::setAwayStatus(const char* mobileId)
+bool SwitchScheduler::setAwayStatus(const char* mobileId)
 {
-    int index = homeMobileIds->indexOf(mobileId);
-    if (index != -1)
+    int handle = homeMobileIds->find(mobileId);
+    if (handle == -1)
     {
-        homeMobileIds->remove(index);
+        return false;
     }
 
+    presenceTimers->cancel(handle);
+    homeMobileIds->remove(handle);
+
     checkToggledState();
+    return true;
 }
 
-void SwitchScheduler::resetHomeStatus()
+bool SwitchScheduler::resetHomeStatus()
 {
-    homeMobileIds->empty();
+    if (homeMobileIds->length() == 0)
+    {
+        return false;
+    }
+
+    presenceTimers->clear();
+    homeMobileIds->clear();
+
     checkToggledState();
+    return true;
+}
+
+void SwitchScheduler::expirePresence()
+{
+    bool hasExpired = false;
+    int handle;
+
+    while ((handle = presenceTimers->poll(clock->millis())) != -1)
+    {
+        DEBUG_PRINT("Mobile id timed out: ");
+        DEBUG_PRINT(homeMobileIds->get(handle));
+        DEBUG_PRINT("\n");
+
+        homeMobileIds->remove(handle);
+        hasExpired = true;
+    }
+
+    if (hasExpired)
+    {
+        checkToggledState();
+    }
 }
 
 unsigned long SwitchScheduler::getLastTimeSync()
@@ -133,7 +448,7 @@ SwitchSchedulerConfiguration* SwitchScheduler::getConfiguration()
     return configuration;
 }
 
-SwitchSchedulerTask** SwitchScheduler::getTasks()
+SwitchSchedulerTask* SwitchScheduler::getTasks()
 {
     return tasks;
 }
@@ -145,36 +460,73 @@ int SwitchScheduler::getTasksLength()
 
 bool SwitchScheduler::shouldBeToggled()
 {
-    uint32_t now = rtc->nowEpoch();
+    time_t now = clock->nowEpoch();
+    ensureScheduleCompiled(now);
 
-    for (int i = 0; i < tasksLength; i++)
+    return activeIntervals->contains(getMinuteOfDay(now));
+}
+
+void SwitchScheduler::addSchedulerTask(SwitchSchedulerTask* task)
+{
+    if (task->startTime.kind == SwitchSchedulerRule::Invalid ||
+        task->endTime.kind == SwitchSchedulerRule::Invalid)
+    {
+        DEBUG_PRINT("Ignoring task with an invalid start or end time.\n");
+        return;
+    }
+
+    // check to see if we need to retrieve astronomy data
+    if (task->startTime.isAstronomical() || task->endTime.isAstronomical())
     {
-        time_t toggleOn = getTime(tasks[i]->startTime);
-        time_t toggleOff = getTime(tasks[i]->endTime);
+        _isUsingAstronomyData = true;
+    }
 
-        if (now > toggleOn && now < toggleOff)
+    if (tasksLength == tasksCapacity)
+    {
+        int capacity = tasksCapacity * 2;
+        SwitchSchedulerTask* resized = new SwitchSchedulerTask[capacity];
+        for (int i = 0; i < tasksLength; i++)
         {
-            return true;
+            resized[i] = tasks[i];
         }
+
+        delete[] tasks;
+        tasks = resized;
+        tasksCapacity = capacity;
+
+        // The resolved times get filled in when the schedule is compiled.
+        delete[] resolvedTasks;
+        resolvedTasks = new SwitchSchedulerResolvedTask[tasksCapacity];
+
+        timeline->reserve(tasksCapacity * TimelineEventsPerTask);
+        activeIntervals->reserve(tasksCapacity * IntervalsPerTask);
     }
 
-    return false;
+    tasks[tasksLength++] = *task;
+    isScheduleDirty = true;
+    stateVersion++;
 }
 
-void SwitchScheduler::addSchedulerTask(SwitchSchedulerTask* task)
+unsigned long SwitchScheduler::getStateVersion()
 {
-    DEBUG_PRINT(task->startTime);
+    return stateVersion;
+}
 
-    // check to see if we need to retrieve astronomy data
-    if (task->startTime == "sunrise" ||
-        task->startTime == "sunset" ||
-        task->endTime == "sunrise" ||
-        task->endTime == "sunset")
+long SwitchScheduler::getSecondsUntilNextEvent()
+{
+    ScheduleTimelineEvent* next = timeline->peek();
+    if (next == NULL)
     {
-        _isUsingAstronomyData = true;
+        return -1;
     }
 
-    tasks[tasksLength++] = task;
+    time_t now = clock->nowEpoch();
+    return next->time > now ? next->time - now : 0;
+}
+
+FireLatencyStats* SwitchScheduler::getFireLatencyStats()
+{
+    return fireLatency;
 }
 
 void SwitchScheduler::tock()
@@ -185,28 +537,13 @@ void SwitchScheduler::tock()
         return;
     }
 
-    if (lastLoopCheck == 0)
-    {
-        uint32_t tNow = rtc->now();
-        while (rtc->second(tNow) != 0)
-        {
-            DEBUG_PRINT("Second: ");
-            DEBUG_PRINT(rtc->second(tNow));
-            DEBUG_PRINT("\n");
-            DEBUG_PRINT(rtc->ISODateString(rtc->now()) + "\n");
-            SPARK_WLAN_Loop();
-            delay(1000);
-            tNow = rtc->now();
-        }
-    }
+    unsigned long now = clock->millis();
 
-    unsigned long now = millis();
-
-    if (now - lastLoopCheck >= checkLoopInterval ||
-        lastLoopCheck == 0)
+    // Signed difference so the deadline survives millis() wrapping.
+    if ((long)(now - nextLoopCheck) >= 0 || !hasLoopChecked)
     {
         DEBUG_PRINT("Tock...");
-        DEBUG_PRINT(rtc->ISODateString(rtc->now()) + "\n");
+        DEBUG_PRINT(rtc->ISODateString(clock->now()) + "\n");
 
         // Sync the time daily.
         syncTime();
@@ -214,14 +551,44 @@ void SwitchScheduler::tock()
         // Try to get the astronomy data if it's time.
         retrieveAstronomyData();
 
-        if (isSchedulerEnabled())
+        // The resolved task times move when DST starts or ends.
+        if (rtc->getZoneOffset(clock->now()) * 3600L != scheduleZoneOffset)
         {
-            // Turn on/off the outlet switch if it's time.
-            checkSchedulerTasks();
+            isScheduleDirty = true;
         }
 
-        lastLoopCheck = now;
+        hasLoopChecked = true;
+        scheduleNextLoopCheck(clock->millis());
+    }
+
+    // Advance the astronomy data retrieval, if there's one in progress.
+    if (astronomyFetcher->isBusy() && astronomyFetcher->step(clock->millis()))
+    {
+        int sunriseMinute = astronomyFetcher->getSunriseHour() * 60 +
+            astronomyFetcher->getSunriseMinute();
+        int sunsetMinute = astronomyFetcher->getSunsetHour() * 60 +
+            astronomyFetcher->getSunsetMinute();
+
+        setAstronomyData(sunriseMinute, sunsetMinute);
+
+        // Remember the override across reboots.
+        astronomyDataDay = getLocalDay(clock->nowEpoch());
+        astronomyCache->store(astronomyDataDay, sunriseMinute, sunsetMinute);
     }
+
+    // Forget the mobile ids that stopped reporting in.
+    expirePresence();
+
+    // Turn on/off the outlet switch if it's time.
+    checkSchedulerTasks();
+}
+
+void SwitchScheduler::scheduleNextLoopCheck(unsigned long now)
+{
+    unsigned long elapsed =
+        (rtc->second(clock->now()) * 1000UL) % checkLoopInterval;
+
+    nextLoopCheck = now + (checkLoopInterval - elapsed);
 }
 
 bool SwitchScheduler::isSchedulerEnabled()
@@ -236,41 +603,226 @@ bool SwitchScheduler::isSchedulerEnabled()
 
 void SwitchScheduler::checkSchedulerTasks()
 {
+    time_t now = clock->nowEpoch();
+
+    // There's nothing to catch up on at start up, and after a long gap
+    // only the last day is replayed. Either way the timeline has to be
+    // rebuilt from the new starting point.
+    if (lastEvaluated == 0 || now - lastEvaluated > maxCatchUpSeconds)
+    {
+        lastEvaluated = lastEvaluated == 0 ? now : now - maxCatchUpSeconds;
+        isScheduleDirty = true;
+    }
+
+    ensureScheduleCompiled(now);
+
+    ScheduleTimelineEvent* next = timeline->peek();
+
+    // Nothing to do until the next transition comes due.
+    if (next == NULL || next->time > now)
+    {
+        lastEvaluated = now > lastEvaluated ? now : lastEvaluated;
+        return;
+    }
+
     DEBUG_PRINT("Checking scheduled tasks... ");
-    DEBUG_PRINT(rtc->ISODateString(rtc->now()) + "\n");
+    DEBUG_PRINT(rtc->ISODateString(clock->now()) + "\n");
+
+    bool isEnabled = isSchedulerEnabled();
+
+    // Fire every transition since the last evaluation in order, however
+    // long ago that was, so a stalled loop doesn't skip any.
+    while (next != NULL && next->time <= now)
+    {
+        // Transitions that come due while the scheduler is disabled are
+        // dropped rather than replayed later. Overlapping tasks are
+        // merged, so a task ending while another one is still running
+        // leaves the switch on.
+        if (isEnabled)
+        {
+            SwitchSchedulerEvent::SwitchSchedulerEventEnum event =
+                isActiveAt(next->time) ?
+                    SwitchSchedulerEvent::StartEvent :
+                    SwitchSchedulerEvent::EndEvent;
+
+            tasks[next->taskIndex].callback(static_cast<int>(event));
+            fireLatency->record(next->time, now);
+            stateVersion++;
+        }
+
+        timeline->pop();
+        next = timeline->peek();
+    }
+
+    lastEvaluated = now;
+
+    // Schedule the next occurrences of the tasks that fired.
+    buildTimeline(now);
+}
+
+void SwitchScheduler::ensureScheduleCompiled(time_t now)
+{
+    if (isScheduleDirty || now >= scheduleExpiration)
+    {
+        compileSchedule();
+    }
+}
+
+void SwitchScheduler::compileSchedule()
+{
+    time_t now = clock->nowEpoch();
+
+    DEBUG_PRINT("Compiling schedule... ");
+    DEBUG_PRINT(rtc->ISODateString(clock->now()) + "\n");
+
+    // Task times are resolved against the current day, so recompile at
+    // the next local midnight.
+    scheduleZoneOffset = rtc->getZoneOffset(clock->now()) * 3600L;
+    scheduleDay = (now + scheduleZoneOffset) / 86400L;
+    scheduleMidnight = scheduleDay * 86400L - scheduleZoneOffset;
+    scheduleExpiration = scheduleMidnight + 86400L;
+
+    activeIntervals->clear();
 
     for (int i = 0; i < tasksLength; i++)
     {
-        checkSchedulerTask(tasks[i], tasks[i]->startTime, SwitchSchedulerEvent::StartEvent);
-        checkSchedulerTask(tasks[i], tasks[i]->endTime, SwitchSchedulerEvent::EndEvent);
+        time_t start = getTime(tasks[i].startTime);
+        time_t end = getTime(tasks[i].endTime);
+
+        // The astronomy data hasn't been retrieved yet.
+        if (start == 0 || end == 0)
+        {
+            resolvedTasks[i].startTime = 0;
+            resolvedTasks[i].endTime = 0;
+            continue;
+        }
+
+        int startMinute = getMinuteOfDay(start);
+        int endMinute = getMinuteOfDay(end);
+        bool isOvernight = endMinute < startMinute;
+
+        resolvedTasks[i].startTime = scheduleMidnight + startMinute * 60L;
+        resolvedTasks[i].endTime = scheduleMidnight + endMinute * 60L +
+            (isOvernight ? 86400L : 0);
+
+        // The part of yesterday's occurrence that runs past midnight.
+        if (isOvernight && tasks[i].isScheduledOn(scheduleDay - 1))
+        {
+            activeIntervals->add(0, endMinute);
+        }
+
+        if (tasks[i].isScheduledOn(scheduleDay))
+        {
+            activeIntervals->add(startMinute,
+                isOvernight ? MinutesPerDay : endMinute);
+        }
+    }
+
+    activeIntervals->build();
+
+    // Keep the transitions that haven't been evaluated yet, even if they
+    // were on the previous day.
+    buildTimeline(lastEvaluated != 0 ? lastEvaluated : now);
+
+    isScheduleDirty = false;
+    stateVersion++;
+}
+
+void SwitchScheduler::buildTimeline(time_t after)
+{
+    timeline->clear();
+
+    // End events go in first so that a task ending at the same time
+    // another one starts leaves the switch on.
+    for (int pass = 0; pass < 2; pass++)
+    {
+        SwitchSchedulerEvent::SwitchSchedulerEventEnum event = pass == 0 ?
+            SwitchSchedulerEvent::EndEvent : SwitchSchedulerEvent::StartEvent;
+
+        for (int i = 0; i < tasksLength; i++)
+        {
+            if (resolvedTasks[i].startTime == 0)
+            {
+                continue;
+            }
+
+            // Look up to a week ahead for the next day the task runs on,
+            // starting with the occurrences that could still have
+            // transitions to catch up on.
+            for (int days = -2; days <= 7; days++)
+            {
+                if (!tasks[i].isScheduledOn(scheduleDay + days))
+                {
+                    continue;
+                }
+
+                time_t start = resolvedTasks[i].startTime + days * 86400L;
+                time_t end = resolvedTasks[i].endTime + days * 86400L;
+
+                if (start > after)
+                {
+                    addTimelineEvent(event == SwitchSchedulerEvent::StartEvent ?
+                        start : end, i, event);
+                    break;
+                }
+
+                if (end > after && event == SwitchSchedulerEvent::EndEvent)
+                {
+                    addTimelineEvent(end, i, event);
+                }
+            }
+        }
     }
 }
 
-void SwitchScheduler::checkSchedulerTask(SwitchSchedulerTask* task,
-    String timeString, SwitchSchedulerEvent::SwitchSchedulerEventEnum event)
+void SwitchScheduler::addTimelineEvent(time_t time, int taskIndex,
+    SwitchSchedulerEvent::SwitchSchedulerEventEnum event)
 {
-    int checkHour, checkMinute;
-    uint32_t now = rtc->now();
-    time_t checkTime = getTime(timeString);
-    Sparky::ParseTimestamp(checkTime, &checkHour, &checkMinute);
+    // The timeline is sized for TimelineEventsPerTask, so this only fails
+    // if that bound is broken.
+    if (!timeline->add(time, taskIndex, static_cast<uint8_t>(event)))
+    {
+        DEBUG_PRINT("The schedule timeline is full, dropping a transition.\n");
+    }
+}
 
-    if (rtc->hour(now) == checkHour && rtc->minute(now) == checkMinute)
+bool SwitchScheduler::isActiveAt(time_t time)
+{
+    for (int i = 0; i < tasksLength; i++)
     {
-        task->callback(static_cast<int>(event));
+        time_t start = resolvedTasks[i].startTime;
+        if (start == 0)
+        {
+            continue;
+        }
+
+        // Tasks are shorter than a day, so only the occurrence that
+        // started last can be running.
+        long days = time >= start ?
+            (time - start) / 86400L :
+            -((start - time + 86399L) / 86400L);
+
+        if (time < resolvedTasks[i].endTime + days * 86400L &&
+            tasks[i].isScheduledOn(scheduleDay + days))
+        {
+            return true;
+        }
     }
+
+    return false;
 }
 
 void SwitchScheduler::syncTime()
 {
-    unsigned long now = millis();
+    unsigned long now = clock->millis();
 
     // just sync the time once a day
     if (now - lastTimeSync > dayInMilliseconds)
     {
         DEBUG_PRINT("Syncing time... ");
-        DEBUG_PRINT(rtc->ISODateString(rtc->now()) + "\n");
+        DEBUG_PRINT(rtc->ISODateString(clock->now()) + "\n");
 
-        Spark.syncTime();
+        clock->sync();
         lastTimeSync = now;
     }
 }
@@ -278,104 +830,172 @@ void SwitchScheduler::syncTime()
 void SwitchScheduler::retrieveAstronomyData()
 {
     // Only retrieve sunset data if we actually need it.
-    if (_isUsingAstronomyData)
+    if (!_isUsingAstronomyData)
+    {
+        return;
+    }
+
+    uint32_t now = clock->now();
+    long today = getLocalDay(clock->nowEpoch());
+    int minuteOfDay = rtc->hour(now) * 60 + rtc->minute(now);
+
+    // Load the sunrise and sunset first thing every day, it doesn't need
+    // the network.
+    if (astronomyCalculatedDay != today && loadAstronomyData(today))
+    {
+        astronomyCalculatedDay = today;
+    }
+
+    // The API is optional and overrides the calculated times.
+    if (configuration->astronomyApiUrl.length() == 0 ||
+        astronomyFetcher->isBusy())
+    {
+        return;
+    }
+
+    // The API gets a fresh set of attempts every day.
+    if (today != astronomyAttemptsDay)
     {
-        int checkHour, checkMinute;
-        uint32_t now = rtc->now();
-        Sparky::ParseTime((configuration->astronomyApiCheckTime).c_str(),
-            &checkHour, &checkMinute);
+        astronomyFetcher->resetAttempts();
+        astronomyAttemptsDay = today;
+    }
 
-        // If the check time has arrived and the last check time wasn't this
-        // minute, or if we've never retrieved the sunset data yet.
-        if ((rtc->hour(now) == checkHour && rtc->minute(now) == checkMinute) ||
-            (sunriseTime == 0 || sunsetTime == 0))
+    // If the check time has passed and the data hasn't been retrieved
+    // today, or if we don't have any sunset data yet.
+    if (astronomyDataDay != today &&
+        (minuteOfDay >= astronomyApiCheckMinute ||
+        sunriseTime == 0 || sunsetTime == 0))
+    {
+        if (astronomyFetcher->start(configuration->astronomyApiUrl))
         {
             DEBUG_PRINT("Retrieving sunset data... ");
-            DEBUG_PRINT(rtc->ISODateString(rtc->now()) + "\n");
-
-            if (parseAndSetAstronomyData())
-            {
-                DEBUG_PRINT("Sunset data retrieved! ");
-                DEBUG_PRINT(rtc->ISODateString(rtc->now()) + "\n");
-            }
-            else
-            {
-                DEBUG_PRINT("Failed to retrieve sunset data, retrying in a few seconds...");
-                delay(5000);
-                retrieveAstronomyData();
-            }
+            DEBUG_PRINT(rtc->ISODateString(clock->now()) + "\n");
         }
     }
 }
 
-bool SwitchScheduler::parseAndSetAstronomyData()
+bool SwitchScheduler::loadAstronomyData(long today)
 {
-    const char* response = getAstronomyDataResponse();
+    int sunriseMinute, sunsetMinute;
 
-    // Parse response if we have one.
-    if (strlen(response) != 0)
+    if (!astronomyCache->lookup(today, &sunriseMinute, &sunsetMinute))
     {
-        ArduinoJson::Parser::JsonParser<64> parser;
-        ArduinoJson::Parser::JsonObject root = parser.parse(const_cast<char*>(response));
-
-        if(root.success())
+        if (!calculateAstronomyData(today, &sunriseMinute, &sunsetMinute))
         {
-            int hour, minute;
-
-            hour = atoi(root["moon_phase"]["sunset"]["hour"]);
-            minute = atoi(root["moon_phase"]["sunset"]["minute"]);
-            sunsetTime = Sparky::ParseTimeFromToday(rtc, hour, minute);
-
-            DEBUG_PRINT("Sunset time: " + Time.timeStr(sunsetTime));
+            return false;
+        }
 
-            hour = atoi(root["moon_phase"]["sunrise"]["hour"]);
-            minute = atoi(root["moon_phase"]["sunrise"]["minute"]);
-            sunriseTime = Sparky::ParseTimeFromToday(rtc, hour, minute);
+        astronomyCache->store(today, sunriseMinute, sunsetMinute);
+    }
 
-            DEBUG_PRINT("Sunrise time: " + Time.timeStr(sunriseTime));
+    setAstronomyData(sunriseMinute, sunsetMinute);
 
-            return true;
+    // Fill in the rest of the window, so it's ready after a reboot.
+    for (long day = today + 1; day < today + AstronomyCacheDays; day++)
+    {
+        int cachedSunrise, cachedSunset;
+        if (!astronomyCache->lookup(day, &cachedSunrise, &cachedSunset) &&
+            calculateAstronomyData(day, &cachedSunrise, &cachedSunset))
+        {
+            astronomyCache->store(day, cachedSunrise, cachedSunset);
         }
     }
 
-    return false;
+    return true;
 }
 
-const char* SwitchScheduler::getAstronomyDataResponse()
+bool SwitchScheduler::calculateAstronomyData(long day, int* sunriseMinute,
+    int* sunsetMinute)
 {
-    Uri apiUri = Uri::Parse(configuration->astronomyApiUrl);
-
-    RestClient client = RestClient(apiUri.Host.c_str());
-    String response = "";
-
-    int statusCode = client.get(apiUri.Path.c_str(), &response);
-
-    if (statusCode == 200)
+    // No location configured.
+    if (configuration->latitude == 0 && configuration->longitude == 0)
     {
-        DEBUG_PRINT("Successfully retrieved JSON response\n");
-        return response.c_str();
+        return false;
     }
-    else
+
+    if (!SolarCalculator::Calculate(
+        day,
+        configuration->latitude,
+        configuration->longitude,
+        static_cast<SolarTwilight::SolarTwilightEnum>(configuration->twilight),
+        getZoneOffsetOnDay(day) * 60,
+        sunriseMinute,
+        sunsetMinute))
     {
-        DEBUG_PRINT("Failed to retrieve sunset data with status: ");
-        DEBUG_PRINT(statusCode);
-        DEBUG_PRINT("\n");
-        return "";
+        DEBUG_PRINT("The sun doesn't rise or set today.\n");
+        return false;
     }
+
+    return true;
+}
+
+uint16_t SwitchScheduler::getAstronomyCacheKey()
+{
+    // FNV-1a over the location, folded into 16 bits.
+    int32_t values[3] =
+    {
+        (int32_t)(configuration->latitude * 1000),
+        (int32_t)(configuration->longitude * 1000),
+        configuration->twilight
+    };
+
+    return (uint16_t)PerfectHash::fold(
+        PerfectHash::hash((const uint8_t*)values, sizeof(values)));
+}
+
+void SwitchScheduler::setAstronomyData(int sunriseMinute, int sunsetMinute)
+{
+    // The minutes are local to the zone offset at noon, like the
+    // calculation, so they're right on the days DST starts or ends.
+    long today = getLocalDay(clock->nowEpoch());
+    time_t midnight = today * 86400L - getZoneOffsetOnDay(today) * 3600L;
+
+    sunsetTime = midnight + sunsetMinute * 60L;
+    DEBUG_PRINT("Sunset time: " + Time.timeStr(sunsetTime));
+
+    sunriseTime = midnight + sunriseMinute * 60L;
+    DEBUG_PRINT("Sunrise time: " + Time.timeStr(sunriseTime));
+
+    isScheduleDirty = true;
+    stateVersion++;
+}
+
+int SwitchScheduler::getZoneOffsetOnDay(long day)
+{
+    // Use the zone offset at noon of that day, so days after a DST change
+    // get the right offset.
+    uint32_t noon = day * 86400L + 12 * 3600L + SPARKTIMEEPOCHSTART;
+    return rtc->getZoneOffset(noon);
+}
+
+long SwitchScheduler::getLocalDay(time_t timestamp)
+{
+    int32_t offset = rtc->getZoneOffset(clock->now()) * 3600L;
+    return (timestamp + offset) / 86400L;
 }
 
-time_t SwitchScheduler::getTime(String timeString)
+time_t SwitchScheduler::getTime(SwitchSchedulerRule rule)
 {
-    if (timeString == "sunrise")
+    switch (rule.kind)
     {
-        return sunriseTime;
+        case SwitchSchedulerRule::Sunrise:
+            return sunriseTime == 0 ? 0 : sunriseTime + rule.offset * 60L;
+        case SwitchSchedulerRule::Sunset:
+            return sunsetTime == 0 ? 0 : sunsetTime + rule.offset * 60L;
+        case SwitchSchedulerRule::Fixed:
+            return scheduleMidnight + rule.minuteOfDay * 60L;
     }
-    else if (timeString == "sunset")
+
+    return 0;
+}
+
+int SwitchScheduler::getMinuteOfDay(time_t timestamp)
+{
+    long seconds = (timestamp - scheduleMidnight) % 86400L;
+    if (seconds < 0)
     {
-        return sunsetTime;
+        seconds += 86400L;
     }
 
-    return Sparky::ParseTimeFromString(
-        rtc,
-        timeString.c_str());
+    return seconds / 60;
 }
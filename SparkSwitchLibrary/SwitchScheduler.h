@@ -2,15 +2,69 @@
 #define SWITCH_SCHEDULER_H_
 
 #include "application.h"
-#include "arraylist.h"
 #include "SparkTime.h"
+#include "ScheduleTimeline.h"
+#include "ScheduleIntervalIndex.h"
+#include "AstronomyDataFetcher.h"
+#include "SolarCalculator.h"
+#include "AstronomyCache.h"
+#include "ScheduleCalendar.h"
+#include "PresenceSet.h"
+#include "TimerWheel.h"
+#include "SwitchClock.h"
+#include "FireLatencyStats.h"
+
+// Large enough for the longest rule string, e.g. "sunrise-1439".
+#define SwitchSchedulerRuleMaxLength 16
+
+// Tasks are shorter than a day, so at most one occurrence of a task can be
+// running at a time. That leaves the end of the running occurrence and the
+// start and end of the next one on the timeline.
+#define TimelineEventsPerTask 3
+
+// An overnight task is split at midnight into two active intervals.
+#define IntervalsPerTask 2
+
+// The longest presence timeout in seconds, a week. The presence timers
+// count in millis(), which would wrap after about 49 days.
+#define PresenceTimeoutMax 604800UL
 
 struct SwitchSchedulerConfiguration
 {
+    // ctor, everything off and the astronomy cache at the start of the
+    // EEPROM.
+    SwitchSchedulerConfiguration();
+
+    // Optional, overrides the calculated sunrise and sunset times with the
+    // ones from the API when set.
     String astronomyApiUrl;
     String astronomyApiCheckTime;
     bool isEnabled;
     bool homeOnlyModeEnabled;
+
+    // Location used to calculate the sunrise and sunset times, in degrees
+    // positive north and east.
+    float latitude;
+    float longitude;
+
+    // One of SolarTwilight::SolarTwilightEnum.
+    uint8_t twilight;
+
+    // Seconds without a home status update before a mobile id counts as
+    // away, or 0 if they never expire.
+    unsigned long presenceTimeout;
+
+    // Seconds to wait for a burst of switch changes to settle before the
+    // last one is written.
+    unsigned long switchCoalesceWindow;
+
+    // Seconds the switch has to stay on or off before it changes again.
+    unsigned long switchMinimumOnTime;
+    unsigned long switchMinimumOffTime;
+
+    // EEPROM address of the astronomy cache, or -1 to only keep it in
+    // memory.
+    int astronomyCacheAddress;
 };
 
 struct SwitchSchedulerEvent
@@ -22,20 +76,99 @@ struct SwitchSchedulerEvent
     };
 };
 
+// The days of the week a task runs on, as bits that can be or'ed together.
+struct SwitchSchedulerDays
+{
+    enum SwitchSchedulerDaysEnum
+    {
+        Sunday = 0x01,
+        Monday = 0x02,
+        Tuesday = 0x04,
+        Wednesday = 0x08,
+        Thursday = 0x10,
+        Friday = 0x20,
+        Saturday = 0x40,
+        Weekdays = 0x3E,
+        Weekends = 0x41,
+        EveryDay = 0x7F
+    };
+};
+
+// A task time compiled from its string form, e.g. "23:59", "sunset" or
+// "sunrise-30", so that evaluating it never has to parse strings.
+struct SwitchSchedulerRule
+{
+    enum SwitchSchedulerRuleKind
+    {
+        Invalid,
+        Fixed,
+        Sunrise,
+        Sunset
+    };
+
+    // One of SwitchSchedulerRuleKind.
+    uint8_t kind;
+
+    // Minutes since midnight of a Fixed rule.
+    uint16_t minuteOfDay;
+
+    // Minutes before (negative) or after a Sunrise or Sunset rule.
+    int16_t offset;
+
+    // True if the rule depends on the astronomy data.
+    bool isAstronomical() const;
+
+    // Compiles a time string into a rule. The rule's kind is Invalid if
+    // the string couldn't be parsed.
+    static SwitchSchedulerRule compile(const char* timeString);
+
+    // Writes the rule back out in its string form.
+    void toString(char* buffer, size_t bufferSize) const;
+};
+
 class SwitchSchedulerTask
 {
     public:
-        SwitchSchedulerTask(String,String,void (*)(int));
-        String startTime;
-        String endTime;
+        SwitchSchedulerTask();
+        SwitchSchedulerTask(const char*, const char*, void (*)(int),
+            uint8_t daysOfWeek = SwitchSchedulerDays::EveryDay,
+            ScheduleCalendar* exceptions = NULL);
+        SwitchSchedulerRule startTime;
+        SwitchSchedulerRule endTime;
         void (*callback)(int);
+
+        // The SwitchSchedulerDays the task runs on.
+        uint8_t daysOfWeek;
+
+        // Dates the task doesn't run on, e.g. holidays, or NULL. The
+        // calendar isn't copied, so it has to outlive the scheduler.
+        ScheduleCalendar* exceptions;
+
+        // True if the task starts on a day, in local days since the unix
+        // epoch. A task that runs past midnight belongs to the day it
+        // started on.
+        bool isScheduledOn(long day);
+};
+
+// A task's occurrence on the compiled day.
+struct SwitchSchedulerResolvedTask
+{
+    // Unix timestamps, or 0 if they rely on astronomy data that hasn't
+    // been retrieved yet. The end is on the next day if the task runs past
+    // midnight.
+    time_t startTime;
+    time_t endTime;
 };
 
 class SwitchScheduler
 {
     public:
-        // ctor
-        SwitchScheduler(SwitchSchedulerConfiguration*, SparkTime*);
+        // ctor, the clock defaults to the device's clock.
+        SwitchScheduler(SwitchSchedulerConfiguration*, SparkTime*,
+            SwitchClock* clock = NULL);
+
+        // Frees the scheduler's pools, and its clock if it created it.
+        ~SwitchScheduler();
 
         void setAstronomyApiUrl(String apiUrl);
 
@@ -45,6 +178,16 @@ class SwitchScheduler
 
         void setHomeOnlyModeEnabled(bool enabled);
 
+        // Sets the location used to calculate the sunrise and sunset times.
+        void setLocation(float latitude, float longitude);
+
+        void setTwilight(SolarTwilight::SolarTwilightEnum twilight);
+
+        // Sets how long a mobile id stays home without an update, in
+        // seconds, 0 to never expire them. Longer timeouts are clamped to
+        // PresenceTimeoutMax.
+        void setPresenceTimeout(unsigned long timeout);
+
         bool isUsingAstronomyData();
 
         bool isDst();
@@ -63,11 +206,22 @@ class SwitchScheduler
 
         int getCurrentHomeCount();
 
-        void setHomeStatus(const char* mobileId);
+        // The home status setters return true if the mobile ids that are
+        // home changed, refreshing one that's already home doesn't count.
+        bool setHomeStatus(const char* mobileId);
+
+        bool setAwayStatus(const char* mobileId);
 
-        void setAwayStatus(const char* mobileId);
+        bool resetHomeStatus();
 
-        void resetHomeStatus();
+        // Defers re-evaluating the switch state until endUpdate(), so that
+        // several settings can be changed with a single re-evaluation.
+        // Updates can be nested.
+        void beginUpdate();
+
+        // Re-evaluates the switch state once if a change since
+        // beginUpdate() called for it.
+        void endUpdate();
 
         // The last time the spark core sync'd itself.
         unsigned long getLastTimeSync();
@@ -75,7 +229,7 @@ class SwitchScheduler
         SwitchSchedulerConfiguration* getConfiguration();
 
         // Get a list of currently registered scheduler tasks.
-        SwitchSchedulerTask** getTasks();
+        SwitchSchedulerTask* getTasks();
 
         // Get the length of the task array.
         int getTasksLength();
@@ -83,22 +237,47 @@ class SwitchScheduler
         // Checks to see if the switch should be toggled on or off.
         bool shouldBeToggled();
 
-        // Adds a task that the scheduler should keep track of.
+        // Adds a task that the scheduler should keep track of. Tasks with
+        // times that couldn't be compiled are ignored. The scheduler keeps
+        // its own copy of the task.
         void addSchedulerTask(SwitchSchedulerTask*);
 
+        // The number of seconds until the next scheduled transition, or -1
+        // if nothing is scheduled.
+        long getSecondsUntilNextEvent();
+
+        // Changes whenever something the switch's state reports changes,
+        // e.g. the settings, the home count, the astronomy data or whether
+        // the switch should be toggled.
+        unsigned long getStateVersion();
+
+        // How late the scheduled transitions have fired.
+        FireLatencyStats* getFireLatencyStats();
+
         // To be called in the Spark loop.
         void tock();
     private:
         // A day in milliseconds.
         const unsigned long dayInMilliseconds = (24 * 60 * 60 * 1000);
 
+        // Transitions missed by more than this many seconds, e.g. while the
+        // device was off, are dropped rather than fired late.
+        const long maxCatchUpSeconds = 24L * 60 * 60;
+
+        // Every transition up to this unix timestamp has been evaluated, or
+        // 0 before the first evaluation.
+        time_t lastEvaluated;
+
         // The last time the time was sync'd.
         unsigned long lastTimeSync;
 
-        // The last time the Tock method was run.
-        unsigned long lastLoopCheck;
+        // When the Tock method next runs its periodic checks, in millis().
+        unsigned long nextLoopCheck;
+
+        // False until the periodic checks have run for the first time.
+        bool hasLoopChecked;
 
-        // How often
+        // How often, checks are aligned to the start of the interval.
         unsigned long checkLoopInterval = (60 * 1000); // every 1 minute
 
         bool _isUsingAstronomyData;
@@ -108,40 +287,161 @@ class SwitchScheduler
         // The time that the sunset will occur for today.
         time_t sunsetTime;
 
-        arraylist<const char*>* homeMobileIds;
+        // Retrieves the astronomy data in the background.
+        AstronomyDataFetcher* astronomyFetcher;
+
+        // The local day the astronomy data was last retrieved on.
+        long astronomyDataDay;
+
+        // The local day the sunrise and sunset were last calculated for.
+        long astronomyCalculatedDay;
+
+        // Sunrise and sunset times of the upcoming days, kept in the EEPROM.
+        AstronomyCache* astronomyCache;
+
+        // The local day the astronomy API attempts were last reset on.
+        long astronomyAttemptsDay;
+
+        // The mobile ids of the people that are home.
+        PresenceSet* homeMobileIds;
+
+        // When each mobile id last reported being home, by handle.
+        time_t homeLastSeen[PresenceSetCapacity];
+
+        // Expires the mobile ids that haven't been updated in a while, by
+        // handle.
+        TimerWheel* presenceTimers;
 
         SparkTime* rtc;
 
+        SwitchClock* clock;
+
+        // Set when the clock was created by the scheduler, not passed in.
+        bool ownsClock;
+
         SwitchSchedulerConfiguration* configuration;
 
-        // TODO: Convert this to arraylist
-        SwitchSchedulerTask** tasks;
+        // Pool of registered tasks, grown as tasks are added.
+        SwitchSchedulerTask* tasks;
+
+        // The number of tasks the pool can hold before it has to grow.
+        int tasksCapacity;
 
         int tasksLength;
 
+        // Every task's transitions resolved for the compiled day, so they
+        // only get resolved once a day rather than on every query.
+        SwitchSchedulerResolvedTask* resolvedTasks;
+
+        // Upcoming start/end transitions of every task, sorted by time.
+        ScheduleTimeline* timeline;
+
+        FireLatencyStats* fireLatency;
+
+        // Today's merged active intervals of every task.
+        ScheduleIntervalIndex* activeIntervals;
+
+        // Set when the tasks or astronomy data change and the schedule
+        // needs to be recompiled.
+        bool isScheduleDirty;
+
+        // The compiled schedule only covers the current day, it's
+        // recompiled once this time has passed.
+        time_t scheduleExpiration;
+
+        // Local midnight of the compiled day.
+        time_t scheduleMidnight;
+
+        // The compiled day in local days since the unix epoch.
+        long scheduleDay;
+
+        // The zone offset in seconds the schedule was compiled with, it's
+        // recompiled when DST starts or ends.
+        int32_t scheduleZoneOffset;
+
         void initialize(SwitchSchedulerConfiguration*);
 
         void checkToggledState();
 
+        // The number of beginUpdate() calls without an endUpdate().
+        int updateDepth;
+
+        // Set when the switch state has to be re-evaluated once the update
+        // ends.
+        bool isToggledStatePending;
+
+        // Incremented by every change getStateVersion() tracks.
+        unsigned long stateVersion;
+
+        // Marks the mobile ids that have timed out as away.
+        void expirePresence();
+
         void checkSchedulerTasks();
 
-        void checkSchedulerTask(SwitchSchedulerTask*, String, SwitchSchedulerEvent::SwitchSchedulerEventEnum);
+        // Schedules the next periodic check at the start of the next
+        // interval on the clock, e.g. the top of the next minute.
+        void scheduleNextLoopCheck(unsigned long now);
+
+        // Resolves every task's times for the current day, compiles
+        // today's active intervals into the interval index and builds the
+        // timeline.
+        void compileSchedule();
+
+        // Adds the transitions of every task that come after a time to the
+        // timeline.
+        void buildTimeline(time_t after);
+
+        // Adds a transition to the timeline, logging if it doesn't fit.
+        void addTimelineEvent(time_t time, int taskIndex,
+            SwitchSchedulerEvent::SwitchSchedulerEventEnum event);
+
+        // True if any task that runs on the day of a unix timestamp is
+        // active at it.
+        bool isActiveAt(time_t);
+
+        // Recompiles the schedule if it's out of date.
+        void ensureScheduleCompiled(time_t now);
 
         // Try to sync the time. It will only sync once a day.
         void syncTime();
 
-        // Try to get the astronomy data. It will only get it at the
-        // configured time.
+        // Calculates the astronomy data once a day, and starts retrieving
+        // it from the API if one is configured and it's due. It's retrieved
+        // once a day at the configured time.
         void retrieveAstronomyData();
 
-        // Retrieve the sunset data from the API and parse it into
-        // a unix timestamp.
-        bool parseAndSetAstronomyData();
+        // Sets today's sunrise and sunset times from the cache, or
+        // calculates them, and fills the cache for the upcoming days.
+        bool loadAstronomyData(long today);
+
+        // Calculates a day's sunrise and sunset times on the device.
+        bool calculateAstronomyData(long day, int* sunriseMinute, int* sunsetMinute);
+
+        // Identifies the location the cached astronomy data is for.
+        uint16_t getAstronomyCacheKey();
+
+        // Updates today's sunrise and sunset times from local minutes since
+        // midnight.
+        void setAstronomyData(int sunriseMinute, int sunsetMinute);
+
+        // The number of local days since the unix epoch.
+        long getLocalDay(time_t);
+
+        // The zone offset in hours that applies to most of a day, once DST
+        // has started or ended.
+        int getZoneOffsetOnDay(long day);
+
+        // The configured astronomy API check time in minutes since
+        // midnight.
+        int astronomyApiCheckMinute;
 
-        // Retrieve the sunset data from the API.
-        const char* getAstronomyDataResponse();
+        // Resolves a rule to a unix timestamp on the compiled day, or 0 if
+        // it relies on astronomy data that hasn't been retrieved yet.
+        time_t getTime(SwitchSchedulerRule);
 
-        time_t getTime(String);
+        // The local minute of the day of a unix timestamp, using the zone
+        // offset the schedule was compiled with.
+        int getMinuteOfDay(time_t);
 };
 
 #endif // SWITCH_SCHEDULER_H_
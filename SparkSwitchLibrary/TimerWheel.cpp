@@ -0,0 +1,136 @@
+#include "TimerWheel.h"
+
+TimerWheel::TimerWheel(int capacity, int bucketsLength, unsigned long tickLength,
+    unsigned long now)
+{
+    this->capacity = capacity;
+    this->bucketsLength = bucketsLength;
+    this->tickLength = tickLength;
+
+    buckets = new int[bucketsLength];
+    next = new int[capacity];
+    previous = new int[capacity];
+    expirations = new long[capacity];
+
+    currentTick = 0;
+    targetTick = 0;
+    lastMillis = now;
+    pendingMillis = 0;
+
+    clear();
+}
+
+TimerWheel::~TimerWheel()
+{
+    delete[] buckets;
+    delete[] next;
+    delete[] previous;
+    delete[] expirations;
+}
+
+void TimerWheel::schedule(int timer, unsigned long delay, unsigned long now)
+{
+    if (isScheduled(timer))
+    {
+        unlink(timer);
+    }
+
+    // Count from the last whole tick the wheel advanced to, so the timer
+    // never expires early. At least one tick, so a timer never expires on
+    // the tick it was scheduled on.
+    delay += pendingMillis + (now - lastMillis);
+    long ticks = (delay + tickLength - 1) / tickLength;
+    expirations[timer] = targetTick + (ticks > 0 ? ticks : 1);
+
+    int bucket = expirations[timer] % bucketsLength;
+    previous[timer] = -1;
+    next[timer] = buckets[bucket];
+    if (buckets[bucket] != -1)
+    {
+        previous[buckets[bucket]] = timer;
+    }
+    buckets[bucket] = timer;
+}
+
+void TimerWheel::cancel(int timer)
+{
+    if (isScheduled(timer))
+    {
+        unlink(timer);
+    }
+}
+
+void TimerWheel::clear()
+{
+    for (int i = 0; i < bucketsLength; i++)
+    {
+        buckets[i] = -1;
+    }
+
+    for (int i = 0; i < capacity; i++)
+    {
+        expirations[i] = -1;
+    }
+}
+
+bool TimerWheel::isScheduled(int timer)
+{
+    return expirations[timer] != -1;
+}
+
+int TimerWheel::poll(unsigned long now)
+{
+    // Accumulate the elapsed time instead of dividing millis(), so the
+    // ticks keep counting up when millis() wraps.
+    pendingMillis += now - lastMillis;
+    lastMillis = now;
+    targetTick += pendingMillis / tickLength;
+    pendingMillis %= tickLength;
+
+    // Every bucket gets visited once per rotation, so there's no need to
+    // step through more than one rotation after a long gap.
+    if (targetTick - currentTick >= bucketsLength)
+    {
+        currentTick = targetTick - bucketsLength + 1;
+    }
+
+    while (true)
+    {
+        // Timers in the bucket that are due on a later rotation stay put.
+        int bucket = currentTick % bucketsLength;
+        for (int timer = buckets[bucket]; timer != -1; timer = next[timer])
+        {
+            if (expirations[timer] <= currentTick)
+            {
+                unlink(timer);
+                return timer;
+            }
+        }
+
+        if (currentTick == targetTick)
+        {
+            return -1;
+        }
+
+        currentTick++;
+    }
+}
+
+void TimerWheel::unlink(int timer)
+{
+    if (previous[timer] != -1)
+    {
+        next[previous[timer]] = next[timer];
+    }
+    else
+    {
+        buckets[expirations[timer] % bucketsLength] = next[timer];
+    }
+
+    if (next[timer] != -1)
+    {
+        previous[next[timer]] = previous[timer];
+    }
+
+    expirations[timer] = -1;
+}
@@ -0,0 +1,70 @@
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+#include "application.h"
+
+// A hashed timer wheel. Timers are numbered from 0 to the capacity and
+// hashed into buckets by the tick they expire on, so scheduling and
+// cancelling a timer take constant time, and advancing the wheel only
+// looks at the timers in the buckets it passes.
+class TimerWheel
+{
+    public:
+        // ctor, the wheel has a bucket for each tick of a rotation and
+        // each tick is the given number of milliseconds long. It starts at
+        // the current millis().
+        TimerWheel(int capacity, int bucketsLength, unsigned long tickLength,
+            unsigned long now);
+
+        ~TimerWheel();
+
+        // Starts or restarts a timer that expires after the given number
+        // of milliseconds from the current millis(), rounded up to the
+        // next tick.
+        void schedule(int timer, unsigned long delay, unsigned long now);
+
+        // Stops a timer.
+        void cancel(int timer);
+
+        // Stops all of the timers.
+        void clear();
+
+        // True if the timer is running.
+        bool isScheduled(int timer);
+
+        // Advances the wheel to the current millis(). Returns a timer that
+        // has expired, or -1 once there are none left. Call it until it
+        // returns -1.
+        int poll(unsigned long now);
+    private:
+        int capacity;
+
+        int bucketsLength;
+
+        unsigned long tickLength;
+
+        // The first timer in each bucket, or -1.
+        int* buckets;
+
+        // Each timer's neighbours in its bucket, or -1.
+        int* next;
+        int* previous;
+
+        // The tick each timer expires on, or -1 if it isn't running.
+        long* expirations;
+
+        // The tick the wheel has advanced to.
+        long currentTick;
+
+        // The millis() the wheel has advanced to, and the milliseconds
+        // since that don't make up a whole tick yet.
+        unsigned long lastMillis;
+        unsigned long pendingMillis;
+
+        // The tick the wheel is advancing to.
+        long targetTick;
+
+        void unlink(int timer);
+};
+
+#endif // TIMER_WHEEL_H_
@@ -0,0 +1,118 @@
+#include "CppUnitTest.h"
+#include "ScheduleCalendar.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace SparkSwitchLibraryTests
+{
+    TEST_CLASS(ScheduleCalendarTests)
+    {
+        ScheduleCalendar calendar;
+
+    public:
+
+        TEST_METHOD_INITIALIZE(Initialize)
+        {
+            calendar.clear();
+        }
+
+        TEST_METHOD(EmptyCalendar)
+        {
+            for (long day = Day(2016, 1, 1); day < Day(2017, 1, 1); day++)
+            {
+                Assert::IsFalse(calendar.contains(day));
+            }
+        }
+
+        TEST_METHOD(DateIsInEveryYear)
+        {
+            calendar.add(7, 4);
+
+            Assert::IsTrue(calendar.contains(Day(2015, 7, 4)));
+            Assert::IsTrue(calendar.contains(Day(2016, 7, 4)));
+            Assert::IsFalse(calendar.contains(Day(2016, 7, 3)));
+            Assert::IsFalse(calendar.contains(Day(2016, 7, 5)));
+        }
+
+        TEST_METHOD(LeapDay)
+        {
+            calendar.add(2, 29);
+
+            Assert::IsTrue(calendar.contains(Day(2016, 2, 29)));
+            Assert::IsTrue(calendar.contains(Day(2000, 2, 29)));
+            Assert::IsFalse(calendar.contains(Day(2016, 2, 28)));
+            Assert::IsFalse(calendar.contains(Day(2016, 3, 1)));
+            Assert::IsFalse(calendar.contains(Day(2015, 2, 28)));
+            Assert::IsFalse(calendar.contains(Day(2015, 3, 1)));
+        }
+
+        TEST_METHOD(LeapDayIsNotInACenturyYear)
+        {
+            calendar.add(2, 29);
+
+            for (long day = Day(2100, 1, 1); day < Day(2101, 1, 1); day++)
+            {
+                Assert::IsFalse(calendar.contains(day));
+            }
+        }
+
+        TEST_METHOD(MarchFirstHasTheSameBitEveryYear)
+        {
+            calendar.add(3, 1);
+
+            Assert::IsTrue(calendar.contains(Day(2015, 3, 1)));
+            Assert::IsTrue(calendar.contains(Day(2016, 3, 1)));
+            Assert::IsTrue(calendar.contains(Day(2100, 3, 1)));
+            Assert::IsFalse(calendar.contains(Day(2015, 2, 28)));
+            Assert::IsFalse(calendar.contains(Day(2016, 2, 29)));
+        }
+
+        TEST_METHOD(EndOfTheYear)
+        {
+            calendar.add(12, 31);
+
+            Assert::IsTrue(calendar.contains(Day(1969, 12, 31)));
+            Assert::IsTrue(calendar.contains(Day(2015, 12, 31)));
+            Assert::IsTrue(calendar.contains(Day(2016, 12, 31)));
+            Assert::IsFalse(calendar.contains(Day(2017, 1, 1)));
+        }
+
+        TEST_METHOD(InvalidDatesAreIgnored)
+        {
+            calendar.add(2, 30);
+            calendar.add(4, 31);
+            calendar.add(0, 1);
+            calendar.add(13, 1);
+            calendar.add(1, 0);
+
+            for (long day = Day(2016, 1, 1); day < Day(2017, 1, 1); day++)
+            {
+                Assert::IsFalse(calendar.contains(day));
+            }
+        }
+
+        TEST_METHOD(RemovedDate)
+        {
+            calendar.add(12, 25);
+            calendar.add(12, 26);
+            calendar.remove(12, 25);
+
+            Assert::IsFalse(calendar.contains(Day(2016, 12, 25)));
+            Assert::IsTrue(calendar.contains(Day(2016, 12, 26)));
+        }
+
+    private:
+
+        // Days since the unix epoch, see
+        // http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+        static long Day(int year, int month, int day)
+        {
+            year -= month <= 2;
+            long era = (year >= 0 ? year : year - 399) / 400;
+            long yearOfEra = year - era * 400;
+            long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+            long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+            return era * 146097 + dayOfEra - 719468;
+        }
+    };
+}
@@ -0,0 +1,127 @@
+#include "CppUnitTest.h"
+#include "ScheduleIntervalIndex.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace SparkSwitchLibraryTests
+{
+    TEST_CLASS(ScheduleIntervalIndexTests)
+    {
+    public:
+
+        TEST_METHOD(EmptyIndex)
+        {
+            ScheduleIntervalIndex index(2);
+            index.build();
+
+            Assert::AreEqual(0, index.length());
+            Assert::IsFalse(index.contains(0));
+        }
+
+        TEST_METHOD(EndIsExclusive)
+        {
+            ScheduleIntervalIndex index(2);
+            index.add(60, 120);
+            index.build();
+
+            Assert::IsFalse(index.contains(59));
+            Assert::IsTrue(index.contains(60));
+            Assert::IsTrue(index.contains(119));
+            Assert::IsFalse(index.contains(120));
+        }
+
+        TEST_METHOD(EmptyIntervalIsIgnored)
+        {
+            ScheduleIntervalIndex index(2);
+            index.add(60, 60);
+            index.build();
+
+            Assert::AreEqual(0, index.length());
+        }
+
+        TEST_METHOD(IntervalAroundMidnightIsSplit)
+        {
+            ScheduleIntervalIndex index(2);
+            index.add(23 * 60, 60);
+            index.build();
+
+            Assert::AreEqual(2, index.length());
+            Assert::IsFalse(index.contains(23 * 60 - 1));
+            Assert::IsTrue(index.contains(23 * 60));
+            Assert::IsTrue(index.contains(MinutesPerDay - 1));
+            Assert::IsTrue(index.contains(0));
+            Assert::IsTrue(index.contains(59));
+            Assert::IsFalse(index.contains(60));
+        }
+
+        TEST_METHOD(OverlappingIntervalsAreMerged)
+        {
+            ScheduleIntervalIndex index(2);
+            index.add(100, 200);
+            index.add(60, 120);
+            index.build();
+
+            Assert::AreEqual(1, index.length());
+            Assert::IsTrue(index.contains(60));
+            Assert::IsTrue(index.contains(199));
+            Assert::IsFalse(index.contains(200));
+        }
+
+        TEST_METHOD(AdjacentIntervalsAreMerged)
+        {
+            ScheduleIntervalIndex index(2);
+            index.add(120, 180);
+            index.add(60, 120);
+            index.build();
+
+            Assert::AreEqual(1, index.length());
+            Assert::IsTrue(index.contains(120));
+        }
+
+        TEST_METHOD(ContainedIntervalIsMerged)
+        {
+            ScheduleIntervalIndex index(2);
+            index.add(60, 300);
+            index.add(100, 200);
+            index.build();
+
+            Assert::AreEqual(1, index.length());
+            Assert::IsTrue(index.contains(250));
+        }
+
+        TEST_METHOD(SplitIntervalMergesOnBothSides)
+        {
+            // 22:00 to 02:00 overlaps 01:00 to 03:00 and 21:00 to 23:00
+            ScheduleIntervalIndex index(2);
+            index.add(22 * 60, 2 * 60);
+            index.add(60, 3 * 60);
+            index.add(21 * 60, 23 * 60);
+            index.build();
+
+            Assert::AreEqual(2, index.length());
+            Assert::IsTrue(index.contains(0));
+            Assert::IsTrue(index.contains(3 * 60 - 1));
+            Assert::IsFalse(index.contains(3 * 60));
+            Assert::IsFalse(index.contains(21 * 60 - 1));
+            Assert::IsTrue(index.contains(21 * 60));
+            Assert::IsTrue(index.contains(MinutesPerDay - 1));
+        }
+
+        TEST_METHOD(DisjointIntervals)
+        {
+            ScheduleIntervalIndex index(1);
+            index.add(500, 600);
+            index.add(100, 200);
+            index.add(300, 400);
+            index.build();
+
+            Assert::AreEqual(3, index.length());
+            Assert::IsTrue(index.contains(150));
+            Assert::IsFalse(index.contains(250));
+            Assert::IsTrue(index.contains(350));
+            Assert::IsFalse(index.contains(450));
+            Assert::IsTrue(index.contains(550));
+            Assert::IsFalse(index.contains(650));
+        }
+    };
+}
@@ -0,0 +1,108 @@
+#include "CppUnitTest.h"
+#include "ScheduleTimeline.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace SparkSwitchLibraryTests
+{
+    TEST_CLASS(ScheduleTimelineTests)
+    {
+    public:
+
+        TEST_METHOD(EmptyTimeline)
+        {
+            ScheduleTimeline timeline(4);
+
+            Assert::IsTrue(timeline.isEmpty());
+            Assert::IsNull(timeline.peek());
+            Assert::AreEqual(0, timeline.length());
+        }
+
+        TEST_METHOD(EventsAreSortedByTime)
+        {
+            ScheduleTimeline timeline(4);
+            timeline.add(300, 0, 0);
+            timeline.add(100, 1, 0);
+            timeline.add(400, 2, 0);
+            timeline.add(200, 3, 0);
+
+            nextEventsMustBe(&timeline, 100, 200, 300, 400);
+        }
+
+        TEST_METHOD(EventsAtTheSameTimeKeepTheirOrder)
+        {
+            ScheduleTimeline timeline(4);
+            timeline.add(200, 0, 0);
+            timeline.add(100, 1, 1);
+            timeline.add(100, 2, 0);
+
+            Assert::AreEqual(1, timeline.peek()->taskIndex);
+            timeline.pop();
+            Assert::AreEqual(2, timeline.peek()->taskIndex);
+            timeline.pop();
+            Assert::AreEqual(0, timeline.peek()->taskIndex);
+        }
+
+        TEST_METHOD(FullTimelineRejectsEvents)
+        {
+            ScheduleTimeline timeline(2);
+
+            Assert::IsTrue(timeline.add(100, 0, 0));
+            Assert::IsTrue(timeline.add(200, 1, 0));
+            Assert::IsFalse(timeline.add(50, 2, 0));
+
+            Assert::AreEqual(2, timeline.length());
+            Assert::AreEqual(100, (int)timeline.peek()->time);
+        }
+
+        TEST_METHOD(PoppedEventsMakeRoom)
+        {
+            ScheduleTimeline timeline(2);
+            timeline.add(100, 0, 0);
+            timeline.add(300, 1, 0);
+            timeline.pop();
+
+            Assert::IsTrue(timeline.add(200, 2, 0));
+            Assert::AreEqual(2, timeline.length());
+            Assert::AreEqual(200, (int)timeline.peek()->time);
+        }
+
+        TEST_METHOD(ReserveKeepsTheEvents)
+        {
+            ScheduleTimeline timeline(2);
+            timeline.add(300, 0, 0);
+            timeline.add(100, 1, 0);
+            timeline.reserve(4);
+            timeline.add(400, 2, 0);
+            timeline.add(200, 3, 0);
+
+            nextEventsMustBe(&timeline, 100, 200, 300, 400);
+        }
+
+        TEST_METHOD(ClearRemovesEveryEvent)
+        {
+            ScheduleTimeline timeline(2);
+            timeline.add(100, 0, 0);
+            timeline.add(200, 1, 0);
+            timeline.clear();
+
+            Assert::IsTrue(timeline.isEmpty());
+            Assert::IsTrue(timeline.add(300, 2, 0));
+        }
+
+    private:
+
+        void nextEventsMustBe(ScheduleTimeline* timeline, int a, int b, int c, int d)
+        {
+            int expected[] = { a, b, c, d };
+
+            for (int i = 0; i < 4; i++)
+            {
+                Assert::AreEqual(expected[i], (int)timeline->peek()->time);
+                timeline->pop();
+            }
+
+            Assert::IsTrue(timeline->isEmpty());
+        }
+    };
+}
@@ -0,0 +1,153 @@
+#include "CppUnitTest.h"
+#include "SchedulerSimulator.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace SparkSwitchLibraryTests
+{
+    // 2014-01-06 00:00 UTC, a Monday, in seconds since 1900 and since the
+    // unix epoch.
+    static const uint32_t MondayNtp = 3597955200UL;
+    static const uint32_t MondayUnix = 1388966400UL;
+
+    static const uint32_t SecondsPerHour = 3600;
+    static const uint32_t SecondsPerDay = 86400;
+
+    // Steps a scheduler in UTC on a virtual clock a minute at a time, and
+    // records when the switch changed state.
+    TEST_CLASS(SchedulerSimulatorTests)
+    {
+        static VirtualClock* clock;
+        static int count;
+        static uint32_t times[16];
+        static int events[16];
+
+        // Task callbacks are plain functions, so they record into these.
+        // The scheduler also calls back with the current state when it
+        // re-evaluates the switch, which only counts if the state changed.
+        static void OnTransition(int event)
+        {
+            if (count > 0 && events[count - 1] == event)
+            {
+                return;
+            }
+
+            if (count < 16)
+            {
+                times[count] = clock->nowEpoch();
+                events[count] = event;
+            }
+
+            count++;
+        }
+
+    public:
+
+        TEST_METHOD_INITIALIZE(Initialize)
+        {
+            clock = NULL;
+            count = 0;
+        }
+
+        TEST_METHOD(EveryDayTaskFiresOnTheMinute)
+        {
+            SwitchSchedulerTask task("19:00", "23:00", &OnTransition);
+            run(&task, MondayNtp, 2);
+
+            Assert::AreEqual(4, count);
+            transitionMustBe(0, MondayUnix + 19 * SecondsPerHour, SwitchSchedulerEvent::StartEvent);
+            transitionMustBe(1, MondayUnix + 23 * SecondsPerHour, SwitchSchedulerEvent::EndEvent);
+            transitionMustBe(2, MondayUnix + SecondsPerDay + 19 * SecondsPerHour, SwitchSchedulerEvent::StartEvent);
+            transitionMustBe(3, MondayUnix + SecondsPerDay + 23 * SecondsPerHour, SwitchSchedulerEvent::EndEvent);
+        }
+
+        TEST_METHOD(WeekdaysTaskSkipsTheWeekend)
+        {
+            SwitchSchedulerTask task("19:00", "23:00", &OnTransition,
+                SwitchSchedulerDays::Weekdays);
+
+            // From Saturday 00:00 until Tuesday 00:00.
+            run(&task, MondayNtp - 2 * SecondsPerDay, 3);
+
+            Assert::AreEqual(2, count);
+            transitionMustBe(0, MondayUnix + 19 * SecondsPerHour, SwitchSchedulerEvent::StartEvent);
+            transitionMustBe(1, MondayUnix + 23 * SecondsPerHour, SwitchSchedulerEvent::EndEvent);
+        }
+
+        TEST_METHOD(TaskPastMidnightEndsTheNextDay)
+        {
+            SwitchSchedulerTask task("22:00", "02:00", &OnTransition,
+                SwitchSchedulerDays::Monday);
+            run(&task, MondayNtp, 2);
+
+            Assert::AreEqual(2, count);
+            transitionMustBe(0, MondayUnix + 22 * SecondsPerHour, SwitchSchedulerEvent::StartEvent);
+            transitionMustBe(1, MondayUnix + SecondsPerDay + 2 * SecondsPerHour, SwitchSchedulerEvent::EndEvent);
+        }
+
+        TEST_METHOD(SimulatorCountsOnlyStateChanges)
+        {
+            SparkTime rtc;
+            rtc.setTimeZone(0);
+            rtc.setUseDST(false);
+
+            SwitchSchedulerConfiguration config;
+            config.isEnabled = true;
+            config.astronomyApiCheckTime = "03:00";
+
+            // The inner task starts and ends while the outer one is on.
+            SchedulerSimulator simulator(&config, &rtc, MondayNtp);
+            SwitchSchedulerTask outer("19:00", "23:00", NULL);
+            SwitchSchedulerTask inner("20:00", "22:00", NULL);
+            simulator.addTask(&outer);
+            simulator.addTask(&inner);
+
+            // The host's Serial discards the report.
+            simulator.run(7, 60, &Serial);
+
+            Assert::AreEqual(14L, simulator.getTransitions());
+        }
+
+    private:
+
+        // Runs the task for a number of days from the given seconds since
+        // 1900, ticking the scheduler every minute.
+        static void run(SwitchSchedulerTask* task, uint32_t start, int days)
+        {
+            SparkTime rtc;
+            rtc.setTimeZone(0);
+            rtc.setUseDST(false);
+
+            SwitchSchedulerConfiguration config;
+            config.isEnabled = true;
+            config.astronomyApiCheckTime = "03:00";
+            config.astronomyCacheAddress = -1;
+
+            clock = new VirtualClock(start);
+            SwitchScheduler* scheduler = new SwitchScheduler(&config, &rtc, clock);
+            scheduler->addSchedulerTask(task);
+
+            for (uint32_t elapsed = 0; elapsed < days * SecondsPerDay; elapsed += 60)
+            {
+                scheduler->tock();
+                clock->advance(60 * 1000UL);
+            }
+
+            delete scheduler;
+            delete clock;
+            clock = NULL;
+        }
+
+        static void transitionMustBe(int index, uint32_t time,
+            SwitchSchedulerEvent::SwitchSchedulerEventEnum event)
+        {
+            Assert::AreEqual(time, times[index]);
+            Assert::AreEqual((int)event, events[index]);
+        }
+    };
+
+    VirtualClock* SchedulerSimulatorTests::clock;
+    int SchedulerSimulatorTests::count;
+    uint32_t SchedulerSimulatorTests::times[16];
+    int SchedulerSimulatorTests::events[16];
+}
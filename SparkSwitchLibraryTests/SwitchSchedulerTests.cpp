@@ -0,0 +1,132 @@
+#include "CppUnitTest.h"
+#include "SwitchScheduler.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace SparkSwitchLibraryTests
+{
+    // 2014-01-06 00:00 UTC, a Monday, in seconds since 1900.
+    static const uint32_t Monday = 3597955200UL;
+
+    TEST_CLASS(SwitchSchedulerTests)
+    {
+        // Task callbacks are plain functions, so they record into these.
+        static int transitions;
+        static int lastEvent;
+
+        static void OnTransition(int event)
+        {
+            transitions++;
+            lastEvent = event;
+        }
+
+    public:
+
+        TEST_METHOD_INITIALIZE(Initialize)
+        {
+            transitions = 0;
+            lastEvent = -1;
+        }
+
+        TEST_METHOD(NothingToCatchUpOnAtStartUp)
+        {
+            SparkTime rtc;
+            VirtualClock* clock = new VirtualClock(Monday + 20 * 3600);
+            SwitchScheduler* scheduler = createScheduler(&rtc, clock);
+
+            scheduler->tock();
+
+            Assert::AreEqual(0, transitions);
+
+            delete scheduler;
+            delete clock;
+        }
+
+        TEST_METHOD(CatchesUpOnEveryTransitionWithinADay)
+        {
+            SparkTime rtc;
+            VirtualClock* clock = new VirtualClock(Monday + 12 * 3600);
+            SwitchScheduler* scheduler = createScheduler(&rtc, clock);
+            scheduler->tock();
+
+            // Stalled from noon until after the task ended at 23:00.
+            clock->advance(12 * 3600 * 1000UL);
+            scheduler->tock();
+
+            Assert::AreEqual(2, transitions);
+            Assert::AreEqual((int)SwitchSchedulerEvent::EndEvent, lastEvent);
+
+            // The start came due 5 hours ago.
+            Assert::AreEqual(5L * 3600, scheduler->getFireLatencyStats()->getMax());
+
+            delete scheduler;
+            delete clock;
+        }
+
+        TEST_METHOD(CatchUpIsCappedAtOneDay)
+        {
+            SparkTime rtc;
+            VirtualClock* clock = new VirtualClock(Monday + 12 * 3600);
+            SwitchScheduler* scheduler = createScheduler(&rtc, clock);
+            scheduler->tock();
+
+            // Stalled for three days, only the last day is replayed.
+            clock->advance(3 * 86400 * 1000UL);
+            scheduler->tock();
+
+            Assert::AreEqual(2, transitions);
+            Assert::AreEqual((int)SwitchSchedulerEvent::EndEvent, lastEvent);
+
+            // The last start came due at 19:00 the day before.
+            Assert::AreEqual(17L * 3600, scheduler->getFireLatencyStats()->getMax());
+
+            delete scheduler;
+            delete clock;
+        }
+
+        TEST_METHOD(CatchUpAfterADayEndsInTheRightState)
+        {
+            SparkTime rtc;
+            VirtualClock* clock = new VirtualClock(Monday + 12 * 3600);
+            SwitchScheduler* scheduler = createScheduler(&rtc, clock);
+            scheduler->tock();
+
+            // Stalled until 20:00 two days later, while the task runs.
+            clock->advance((2 * 86400 + 8 * 3600) * 1000UL);
+            scheduler->tock();
+
+            // Yesterday's end, which was after the start of the last day,
+            // and today's start.
+            Assert::AreEqual(2, transitions);
+            Assert::AreEqual((int)SwitchSchedulerEvent::StartEvent, lastEvent);
+            Assert::IsTrue(scheduler->shouldBeToggled());
+
+            delete scheduler;
+            delete clock;
+        }
+
+    private:
+
+        // A scheduler in UTC that's on from 19:00 to 23:00 every day.
+        static SwitchScheduler* createScheduler(SparkTime* rtc, SwitchClock* clock)
+        {
+            rtc->setTimeZone(0);
+            rtc->setUseDST(false);
+
+            SwitchSchedulerConfiguration config;
+            config.isEnabled = true;
+            config.astronomyApiCheckTime = "03:00";
+            config.astronomyCacheAddress = -1;
+
+            SwitchScheduler* scheduler = new SwitchScheduler(&config, rtc, clock);
+
+            SwitchSchedulerTask task("19:00", "23:00", &OnTransition);
+            scheduler->addSchedulerTask(&task);
+
+            return scheduler;
+        }
+    };
+
+    int SwitchSchedulerTests::transitions;
+    int SwitchSchedulerTests::lastEvent;
+}
@@ -0,0 +1,41 @@
+#include <chrono>
+#include "application.h"
+
+SerialClass Serial;
+SparkClass Spark;
+TimeClass Time;
+RGBClass RGB;
+EEPROMClass EEPROM;
+
+static const std::chrono::steady_clock::time_point started =
+    std::chrono::steady_clock::now();
+
+unsigned long millis()
+{
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+}
+
+unsigned long micros()
+{
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - started).count();
+}
+
+void delay(unsigned long milliseconds)
+{
+    unsigned long start = millis();
+    while (millis() - start < milliseconds)
+    {
+    }
+}
+
+long random(long howBig)
+{
+    return howBig > 0 ? rand() % howBig : 0;
+}
+
+long random(long howSmall, long howBig)
+{
+    return howSmall < howBig ? howSmall + random(howBig - howSmall) : howSmall;
+}
@@ -0,0 +1,305 @@
+#ifndef APPLICATION_H_
+#define APPLICATION_H_
+
+// Stands in for the Spark firmware's application.h, so the library can be
+// built and tested on the host. Only the parts of the firmware's API the
+// library uses are here, and none of them touch any hardware: the network
+// never answers, the EEPROM is a buffer and the serial output goes nowhere.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+
+#ifndef min
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+#ifndef max
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+// Milliseconds and microseconds since the tests started.
+unsigned long millis();
+unsigned long micros();
+
+void delay(unsigned long milliseconds);
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+
+inline void pinMode(int, int) {}
+inline void digitalWrite(int, int) {}
+inline void SPARK_WLAN_Loop() {}
+
+class String
+{
+    public:
+        String() {}
+        String(const char* text) : text(text != NULL ? text : "") {}
+        String(const std::string& text) : text(text) {}
+        String(char c) : text(1, c) {}
+        String(int value) : text(std::to_string(value)) {}
+        String(unsigned int value) : text(std::to_string(value)) {}
+        String(long value) : text(std::to_string(value)) {}
+        String(unsigned long value) : text(std::to_string(value)) {}
+
+        const char* c_str() const { return text.c_str(); }
+        unsigned int length() const { return text.size(); }
+        int toInt() const { return atoi(text.c_str()); }
+
+        int indexOf(char c, unsigned int from = 0) const
+        {
+            size_t found = text.find(c, from);
+            return found == std::string::npos ? -1 : (int)found;
+        }
+
+        int indexOf(const char* s, unsigned int from = 0) const
+        {
+            size_t found = text.find(s, from);
+            return found == std::string::npos ? -1 : (int)found;
+        }
+
+        String substring(unsigned int from) const
+        {
+            return substring(from, text.size());
+        }
+
+        // Like the firmware's, the bounds can come in either order.
+        String substring(unsigned int from, unsigned int to) const
+        {
+            if (from > to) { unsigned int t = from; from = to; to = t; }
+            if (from > text.size()) { return String(); }
+            if (to > text.size()) { to = text.size(); }
+            return String(text.substr(from, to - from));
+        }
+
+        bool concat(char c) { text += c; return true; }
+        bool concat(const char* s) { text += s; return true; }
+
+        String& operator+=(const String& s) { text += s.text; return *this; }
+        String& operator+=(const char* s) { text += s; return *this; }
+        String& operator+=(char c) { text += c; return *this; }
+        String& operator+=(int value) { return *this += String(value); }
+        String& operator+=(unsigned int value) { return *this += String(value); }
+        String& operator+=(long value) { return *this += String(value); }
+        String& operator+=(unsigned long value) { return *this += String(value); }
+
+        bool operator==(const String& s) const { return text == s.text; }
+        bool operator==(const char* s) const { return text == s; }
+        bool operator!=(const String& s) const { return text != s.text; }
+        bool operator!=(const char* s) const { return text != s; }
+
+        char operator[](unsigned int index) const
+        {
+            return index < text.size() ? text[index] : 0;
+        }
+
+        friend String operator+(const String& a, const String& b)
+        {
+            return String(a.text + b.text);
+        }
+    private:
+        std::string text;
+};
+
+class Print
+{
+    public:
+        virtual ~Print() {}
+
+        virtual size_t write(uint8_t c) = 0;
+
+        virtual size_t write(const uint8_t* buffer, size_t length)
+        {
+            for (size_t i = 0; i < length; i++) { write(buffer[i]); }
+            return length;
+        }
+
+        size_t print(const char* s)
+        {
+            return write((const uint8_t*)s, strlen(s));
+        }
+
+        size_t print(const String& s) { return print(s.c_str()); }
+        size_t print(char c) { return write((uint8_t)c); }
+        size_t print(int value) { return print((long)value); }
+        size_t print(unsigned int value) { return print((unsigned long)value); }
+
+        size_t print(long value)
+        {
+            char buffer[24];
+            snprintf(buffer, sizeof(buffer), "%ld", value);
+            return print(buffer);
+        }
+
+        size_t print(unsigned long value)
+        {
+            char buffer[24];
+            snprintf(buffer, sizeof(buffer), "%lu", value);
+            return print(buffer);
+        }
+
+        size_t print(double value, int digits = 2)
+        {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+            return print(buffer);
+        }
+
+        size_t println() { return print("\r\n"); }
+        size_t println(const char* s) { return print(s) + println(); }
+        size_t println(const String& s) { return print(s) + println(); }
+        size_t println(long value) { return print(value) + println(); }
+        size_t println(unsigned long value) { return print(value) + println(); }
+};
+
+class Printable
+{
+    public:
+        virtual ~Printable() {}
+
+        virtual size_t printTo(Print& p) const = 0;
+};
+
+class SerialClass : public Print
+{
+    public:
+        void begin(long) {}
+        int available() { return 0; }
+        size_t write(uint8_t) { return 1; }
+        using Print::write;
+};
+
+extern SerialClass Serial;
+
+class IPAddress
+{
+    public:
+        IPAddress() { memset(address, 0, sizeof(address)); }
+
+        IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        {
+            address[0] = a; address[1] = b; address[2] = c; address[3] = d;
+        }
+
+        uint8_t& operator[](int index) { return address[index]; }
+    private:
+        uint8_t address[4];
+};
+
+// Never receives anything.
+class UDP
+{
+    public:
+        virtual ~UDP() {}
+
+        virtual uint8_t begin(uint16_t) { return 1; }
+        virtual int beginPacket(const char*, uint16_t) { return 1; }
+        virtual int beginPacket(IPAddress, uint16_t) { return 1; }
+        virtual int endPacket() { return 1; }
+        virtual size_t write(uint8_t) { return 1; }
+        virtual size_t write(const uint8_t*, size_t length) { return length; }
+        virtual int parsePacket() { return 0; }
+        virtual int read() { return -1; }
+        virtual int read(unsigned char*, size_t) { return 0; }
+        virtual void stop() {}
+};
+
+// Never connects.
+class TCPClient : public Print
+{
+    public:
+        int connect(const char*, uint16_t) { return 0; }
+        int connect(IPAddress, uint16_t) { return 0; }
+        uint8_t connected() { return 0; }
+        int available() { return 0; }
+        int read() { return -1; }
+        void flush() {}
+        void stop() {}
+        size_t write(uint8_t) { return 1; }
+        using Print::write;
+};
+
+// Never resolves.
+inline long gethostbyname(char*, uint16_t, uint32_t*) { return -1; }
+
+enum Spark_Data_TypeDef { BOOLEAN = 1, INT = 2, STRING = 4, DOUBLE = 9 };
+
+class SparkClass
+{
+    public:
+        void publish(const char*, const char*) {}
+        void publish(String, String) {}
+        void syncTime() {}
+        void variable(const char*, void*, Spark_Data_TypeDef) {}
+        void function(const char*, int (*)(String)) {}
+};
+
+extern SparkClass Spark;
+
+// The time in UTC, plus the zone.
+class TimeClass
+{
+    public:
+        TimeClass() : zoneOffset(0) {}
+
+        time_t now() { return (time_t)(millis() / 1000); }
+        void zone(float offset) { zoneOffset = (long)(offset * 3600); }
+
+        int year(time_t t) { return local(t)->tm_year + 1900; }
+        int month(time_t t) { return local(t)->tm_mon + 1; }
+        int day(time_t t) { return local(t)->tm_mday; }
+        int hour(time_t t) { return local(t)->tm_hour; }
+        int minute(time_t t) { return local(t)->tm_min; }
+        int second(time_t t) { return local(t)->tm_sec; }
+
+        String timeStr(time_t t) { return String(asctime(local(t))); }
+    private:
+        long zoneOffset;
+
+        struct tm* local(time_t t)
+        {
+            t += zoneOffset;
+            return gmtime(&t);
+        }
+};
+
+extern TimeClass Time;
+
+class RGBClass
+{
+    public:
+        void control(bool) {}
+        void color(int, int, int) {}
+};
+
+extern RGBClass RGB;
+
+// Starts out erased, like a new device.
+class EEPROMClass
+{
+    public:
+        EEPROMClass() { memset(data, 0xFF, sizeof(data)); }
+
+        uint8_t read(int address) { return data[address]; }
+        void write(int address, uint8_t value) { data[address] = value; }
+    private:
+        uint8_t data[100];
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // APPLICATION_H_
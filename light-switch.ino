@@ -13,7 +13,7 @@ LightSwitch* ls;
 UDP* udpClient;
 SparkTime* rtc;
 SwitchSchedulerConfiguration* config;
-char currentState[StringVariableMaxLength] = "{\"error\":\"not initialized\"}";
+ScheduleCalendar* holidays;
 
 void setup()
 {
@@ -26,23 +26,51 @@ void setup()
 
     // TODO: retrieve intial configuration from the web
     config = new SwitchSchedulerConfiguration();
-    config->astronomyApiUrl = astronomyApiUrl;
+    config->latitude = 33.80;   // 30329
+    config->longitude = -84.33;
+    config->twilight = SolarTwilight::Official;
+
+    // The sunrise and sunset are calculated on the device, the API is only
+    // needed to override them.
+    // config->astronomyApiUrl = astronomyApiUrl;
     config->astronomyApiCheckTime = "03:00";
     config->isEnabled = true;
     config->homeOnlyModeEnabled = false;
     // config->homeOnlyModeEnabled = true;
 
+    // Phones that haven't checked in for 12 hours count as away.
+    config->presenceTimeout = 12 * 3600UL;
+
+    // Let bursts of changes settle, and keep the relay from cycling.
+    config->switchCoalesceWindow = 2;
+    config->switchMinimumOnTime = 60;
+    config->switchMinimumOffTime = 60;
+
     ls = new LightSwitch(config, rtc);
     ls->setOutletSwitchPin(D7);
-    ls->addSchedule(new SwitchSchedulerTask("sunset", "23:59", &schedulerHandler));
-    // ls->addSchedule(new SwitchSchedulerTask("sunset", "02:30", &schedulerHandler));
-    // ls->addSchedule(new SwitchSchedulerTask("23:35", "23:40", &schedulerHandler));
-    // ls->addSchedule(new SwitchSchedulerTask("23:45", "23:50", &schedulerHandler));
-    // ls->addSchedule(new SwitchSchedulerTask("23:55", "00:00", &schedulerHandler));
+
+    // The scheduler keeps its own copy of each task.
+    SwitchSchedulerTask task("sunset", "23:59", &schedulerHandler);
+    ls->addSchedule(&task);
+    // task = SwitchSchedulerTask("sunset", "02:30", &schedulerHandler);
+    // ls->addSchedule(&task);
+    // task = SwitchSchedulerTask("23:35", "23:40", &schedulerHandler);
+    // ls->addSchedule(&task);
+
+    // Tasks can be limited to some days of the week, and skip holidays.
+    // holidays = new ScheduleCalendar();
+    // holidays->add(1, 1);
+    // holidays->add(7, 4);
+    // holidays->add(12, 25);
+    // task = SwitchSchedulerTask("06:30", "sunrise", &schedulerHandler,
+    //     SwitchSchedulerDays::Weekdays, holidays);
+    // ls->addSchedule(&task);
 
     Spark.function("configure", configureHandler);
     Spark.function("identify", identifyHandler);
-    Spark.variable("current", &currentState, STRING);
+    // The state and stats are printed in place by ls->tick().
+    Spark.variable("current", (void*) ls->getCurrentState(), STRING);
+    Spark.variable("latency", (void*) ls->getFireLatency(), STRING);
 
     #ifdef SPARK_DEBUG
     RGB.control(true);
@@ -79,10 +107,7 @@ void loop()
 {
     ls->tick();
 
-    char* tmp = const_cast<char*>(ls->getCurrentState());
-    strcpy(currentState, tmp);
-
-    // DEBUG_PRINT(currentState);
+    // DEBUG_PRINT(ls->getCurrentState());
     // DEBUG_PRINT("\n");
 
     // Wait 10 seconds